@@ -42,21 +42,12 @@ arm_job_t example_rotate_job = {
 		  {39, 141}, {38, 142}, {37, 143}, {36, 144}, {35, 145}, {34, 146}, {33, 147},
 		  {32, 148}, {31, 149}, {30, 150}}};
 
-static const struct rectangle obstacles[] = {
+static const struct obstacle obstacles[] = {
 	/* Rectangle off to the left of arm */
-	{.bottom = {.x1 = 60, .y1 = 90, .x2 = 74, .y2 = 90},
-	 .top = {.x1 = 60, .y1 = 104, .x2 = 74, .y2 = 104},
-	 .left = {.x1 = 60, .y1 = 90, .x2 = 60, .y2 = 104},
-	 .right = {.x1 = 74, .y1 = 90, .x2 = 74, .y2 = 104}},
+	MAP_OBSTACLE_RECTANGLE(60, 90, 74, 104),
 
 	/* Rectangle directly above arm and middle */
-	{.bottom = {.x1 = 200, .y1 = 200, .x2 = 225, .y2 = 200},
-	 .top = {.x1 = 200, .y1 = 260, .x2 = 225, .y2 = 260},
-	 .left = {.x1 = 200, .y1 = 200, .x2 = 200, .y2 = 260},
-	 .right = {.x1 = 225, .y1 = 200, .x2 = 225, .y2 = 260}},
+	MAP_OBSTACLE_RECTANGLE(200, 200, 225, 260),
 
-	{.bottom = {.x1 = 230, .y1 = 170, .x2 = 260, .y2 = 170},
-	 .top = {.x1 = 230, .y1 = 195, .x2 = 260, .y2 = 195},
-	 .left = {.x1 = 230, .y1 = 170, .x2 = 230, .y2 = 195},
-	 .right = {.x1 = 260, .y1 = 170, .x2 = 260, .y2 = 195}},
+	MAP_OBSTACLE_RECTANGLE(230, 170, 260, 195),
 };
@@ -5,15 +5,35 @@
 #ifndef APP_PATH_COMMON_H_
 #define APP_PATH_COMMON_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * @brief Dimension of workspace 2D array
  */
 #define WORKSPACE_DIMENSION CONFIG_PATHFIND_WORKSPACE_SQMM
 
 /**
- * @brief Configuration space dimensions in degrees^2
+ * @brief Number of cspace cells along each side, one per CONFIG_PATHFIND_ARM_DEGREE_INC
+ */
+#define CSPACE_DIMENSION                                                                           \
+	((CONFIG_PATHFIND_ARM_RANGE + CONFIG_PATHFIND_ARM_DEGREE_INC - 1) /                        \
+	 CONFIG_PATHFIND_ARM_DEGREE_INC)
+
+/**
+ * @brief Cspace cell holding an angle in degrees
+ */
+#define CSPACE_CELL(angle) ((angle) / CONFIG_PATHFIND_ARM_DEGREE_INC)
+
+/**
+ * @brief Angle in degrees of a cspace cell
+ */
+#define CSPACE_ANGLE(cell) ((cell) * CONFIG_PATHFIND_ARM_DEGREE_INC)
+
+/**
+ * @brief Number of 32-bit words holding one row of a cspace bitmap
  */
-#define CSPACE_DIMENSION CONFIG_PATHFIND_ARM_RANGE / CONFIG_PATHFIND_ARM_DEGREE_INC
+#define CSPACE_ROW_WORDS ((CSPACE_DIMENSION + 31) / 32)
 
 /**
  * @brief markers used in cspace and wspace maps
@@ -26,4 +46,44 @@ enum markers {
 	PATH = 4U,
 };
 
+/**
+ * @brief Check a cell of a cspace bitmap
+ *
+ * Bitmaps are stored row per theta1 cell, with one bit per theta0 cell.
+ *
+ * @param[in] bitmap Pointer to cspace bitmap
+ * @param[in] x Column (theta0 cell) of the cell
+ * @param[in] y Row (theta1 cell) of the cell
+ *
+ * @retval True if bit is set, False otherwise
+ */
+static inline bool cspace_bit_test(const uint32_t (*bitmap)[CSPACE_ROW_WORDS], int x, int y)
+{
+	return (bitmap[y][x / 32] >> (x % 32)) & 1U;
+}
+
+/**
+ * @brief Set a cell of a cspace bitmap
+ *
+ * @param[in] bitmap Pointer to cspace bitmap
+ * @param[in] x Column (theta0 cell) of the cell
+ * @param[in] y Row (theta1 cell) of the cell
+ */
+static inline void cspace_bit_set(uint32_t (*bitmap)[CSPACE_ROW_WORDS], int x, int y)
+{
+	bitmap[y][x / 32] |= 1U << (x % 32);
+}
+
+/**
+ * @brief Clear a cell of a cspace bitmap
+ *
+ * @param[in] bitmap Pointer to cspace bitmap
+ * @param[in] x Column (theta0 cell) of the cell
+ * @param[in] y Row (theta1 cell) of the cell
+ */
+static inline void cspace_bit_clear(uint32_t (*bitmap)[CSPACE_ROW_WORDS], int x, int y)
+{
+	bitmap[y][x / 32] &= ~(1U << (x % 32));
+}
+
 #endif /* APP_PATH_COMMON_H_ */
\ No newline at end of file
@@ -8,20 +8,205 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <math.h>
 #include <zephyr/kernel.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+#if defined(CONFIG_MAP_UTILS_NUMERIC_FIXED)
+
+/**
+ * @brief Scalar type used for geometry and kinematics, Q16.16 fixed point
+ */
+typedef int32_t map_real_t;
+
+/**
+ * @brief Type holding the product of two map_real_t, Q32.32 fixed point
+ */
+typedef int64_t map_wide_t;
+
+/** @brief Convert a constant or double to map_real_t, rounding to nearest */
+#define MAP_REAL(x) ((map_real_t)((x) * 65536.0 + (((x) >= 0) ? 0.5 : -0.5)))
+/** @brief Convert an integer to map_real_t */
+#define MAP_REAL_FROM_INT(x) ((map_real_t)((x) * 65536))
+/** @brief Convert a map_real_t to double */
+#define MAP_REAL_TO_DOUBLE(x) ((double)(x) / 65536.0)
+/** @brief Smallest integer not less than a map_real_t */
+#define MAP_REAL_CEIL(x) ((int)(((x) + 0xFFFF) >> 16))
+/** @brief Largest integer not greater than a map_real_t */
+#define MAP_REAL_FLOOR(x) ((int)((x) >> 16))
+/** @brief Multiply two map_real_t */
+#define MAP_REAL_MUL(a, b) ((map_real_t)(((int64_t)(a) * (b)) >> 16))
+/** @brief Compute a * b / c keeping the full precision of the product */
+#define MAP_REAL_MULDIV(a, b, c) ((map_real_t)(((int64_t)(a) * (b)) / (c)))
+/** @brief Multiply two map_real_t into a map_wide_t, comparable only to other products */
+#define MAP_WIDE_MUL(a, b) ((map_wide_t)(a) * (b))
+
+/**
+ * @brief Square root of a product of two map_real_t
+ *
+ * @param[in] x Non-negative product, such as a squared length
+ *
+ * @return Square root as map_real_t
+ */
+static inline map_real_t map_wide_sqrt(map_wide_t x)
+{
+	/* sqrt of a Q32.32 value is the Q16.16 result, found bit by bit */
+	uint64_t rem = (uint64_t)x;
+	uint64_t root = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > rem) {
+		bit >>= 2;
+	}
+
+	while (bit != 0) {
+		if (rem >= root + bit) {
+			rem -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	/* Round to nearest rather than down */
+	if (rem > root) {
+		root++;
+	}
+
+	return (map_real_t)root;
+}
+
+#else
+
+#if defined(CONFIG_MAP_UTILS_NUMERIC_FLOAT)
+/**
+ * @brief Scalar type used for geometry and kinematics, single precision
+ */
+typedef float map_real_t;
+
+/** @brief Smallest integer not less than a map_real_t */
+#define MAP_REAL_CEIL(x) ((int)ceilf(x))
+/** @brief Largest integer not greater than a map_real_t */
+#define MAP_REAL_FLOOR(x) ((int)floorf(x))
+#else
+/**
+ * @brief Scalar type used for geometry and kinematics, double precision
+ */
+typedef double map_real_t;
+
+/** @brief Smallest integer not less than a map_real_t */
+#define MAP_REAL_CEIL(x) ((int)ceil(x))
+/** @brief Largest integer not greater than a map_real_t */
+#define MAP_REAL_FLOOR(x) ((int)floor(x))
+#endif
+
+/**
+ * @brief Type holding the product of two map_real_t
+ */
+typedef map_real_t map_wide_t;
+
+/** @brief Convert a constant or double to map_real_t */
+#define MAP_REAL(x) ((map_real_t)(x))
+/** @brief Convert an integer to map_real_t */
+#define MAP_REAL_FROM_INT(x) ((map_real_t)(x))
+/** @brief Convert a map_real_t to double */
+#define MAP_REAL_TO_DOUBLE(x) ((double)(x))
+/** @brief Multiply two map_real_t */
+#define MAP_REAL_MUL(a, b) ((a) * (b))
+/** @brief Compute a * b / c keeping the full precision of the product */
+#define MAP_REAL_MULDIV(a, b, c) ((a) * ((b) / (c)))
+/** @brief Multiply two map_real_t into a map_wide_t, comparable only to other products */
+#define MAP_WIDE_MUL(a, b) ((a) * (b))
+
+/**
+ * @brief Square root of a product of two map_real_t
+ *
+ * @param[in] x Non-negative product, such as a squared length
+ *
+ * @return Square root as map_real_t
+ */
+static inline map_real_t map_wide_sqrt(map_wide_t x)
+{
+#if defined(CONFIG_MAP_UTILS_NUMERIC_FLOAT)
+	return sqrtf(x);
+#else
+	return sqrt(x);
+#endif
+}
+
+#endif /* CONFIG_MAP_UTILS_NUMERIC_FIXED */
+
+/**
+ * @brief Initializer for an axis-aligned struct rectangle from whole millimetre bounds
+ */
+#define MAP_RECTANGLE(min_x, min_y, max_x, max_y)                                                  \
+	{                                                                                          \
+		.bottom = {MAP_REAL_FROM_INT(min_x), MAP_REAL_FROM_INT(min_y),                     \
+			   MAP_REAL_FROM_INT(max_x), MAP_REAL_FROM_INT(min_y)},                    \
+		.top = {MAP_REAL_FROM_INT(min_x), MAP_REAL_FROM_INT(max_y),                        \
+			MAP_REAL_FROM_INT(max_x), MAP_REAL_FROM_INT(max_y)},                       \
+		.left = {MAP_REAL_FROM_INT(min_x), MAP_REAL_FROM_INT(min_y),                       \
+			 MAP_REAL_FROM_INT(min_x), MAP_REAL_FROM_INT(max_y)},                      \
+		.right = {MAP_REAL_FROM_INT(max_x), MAP_REAL_FROM_INT(min_y),                      \
+			  MAP_REAL_FROM_INT(max_x), MAP_REAL_FROM_INT(max_y)},                     \
+	}
+
+/**
+ * @brief Initializer for a struct vertex from whole millimetre coordinates
+ */
+#define MAP_VERTEX(x, y) {MAP_REAL_FROM_INT(x), MAP_REAL_FROM_INT(y)}
+
+/**
+ * @brief Initializer for a struct circle from whole millimetre centre and radius
+ */
+#define MAP_CIRCLE(x, y, r) {.centre = MAP_VERTEX(x, y), .radius = MAP_REAL_FROM_INT(r)}
+
+/**
+ * @brief Initializer for a rectangle struct obstacle, see MAP_RECTANGLE()
+ */
+#define MAP_OBSTACLE_RECTANGLE(min_x, min_y, max_x, max_y)                                         \
+	{.shape = MAP_SHAPE_RECTANGLE, .rectangle = MAP_RECTANGLE(min_x, min_y, max_x, max_y)}
+
+/**
+ * @brief Initializer for a polygon struct obstacle from its MAP_VERTEX() vertices
+ */
+#define MAP_OBSTACLE_POLYGON(...)                                                                  \
+	{                                                                                          \
+		.shape = MAP_SHAPE_POLYGON,                                                        \
+		.polygon = {                                                                       \
+			.num_vertices = sizeof((struct vertex[]){__VA_ARGS__}) /                   \
+					sizeof(struct vertex),                                     \
+			.vertices = {__VA_ARGS__},                                                 \
+		},                                                                                 \
+	}
+
+/**
+ * @brief Initializer for a circle struct obstacle, see MAP_CIRCLE()
+ */
+#define MAP_OBSTACLE_CIRCLE(x, y, r) {.shape = MAP_SHAPE_CIRCLE, .circle = MAP_CIRCLE(x, y, r)}
+
+/**
+ * @brief Upper limit for the number of vertices of a polygon
+ */
+#define MAP_POLYGON_MAX_VERTICES 8
+
+/**
+ * @brief Convert whole degrees to trig lookup table steps
+ */
+#define MAP_UTILS_DEG_TO_STEPS(deg) ((deg) * CONFIG_MAP_UTILS_TRIG_STEPS_PER_DEG)
+
 /**
  * @brief Struct defining a line segment
  */
 struct segment {
-	double x1; /** origin x coordinate */
-	double y1; /** origin y coordinate */
-	double x2; /** ending x coordinate */
-	double y2; /** ending y coordinate */
+	map_real_t x1; /** origin x coordinate */
+	map_real_t y1; /** origin y coordinate */
+	map_real_t x2; /** ending x coordinate */
+	map_real_t y2; /** ending y coordinate */
 };
 
 /**
@@ -34,12 +219,99 @@ struct rectangle {
 	struct segment right;  /** right segment of rectangle */
 };
 
+/**
+ * @brief Struct defining a point
+ */
+struct vertex {
+	map_real_t x; /** x coordinate */
+	map_real_t y; /** y coordinate */
+};
+
+/**
+ * @brief Struct defining a convex polygon
+ *
+ * Vertices follow the outline in either direction.
+ */
+struct polygon {
+	uint8_t num_vertices;                             /** number of vertices, at least 3 */
+	struct vertex vertices[MAP_POLYGON_MAX_VERTICES]; /** vertices along the outline */
+};
+
+/**
+ * @brief Struct defining a circle
+ */
+struct circle {
+	struct vertex centre; /** centre of the circle */
+	map_real_t radius;    /** radius of the circle */
+};
+
+/**
+ * @brief Shapes an obstacle can take
+ */
+enum map_shape {
+	MAP_SHAPE_RECTANGLE,
+	MAP_SHAPE_POLYGON,
+	MAP_SHAPE_CIRCLE,
+};
+
+/**
+ * @brief Struct defining an obstacle of any shape
+ */
+struct obstacle {
+	uint8_t shape; /** enum map_shape selecting the member below */
+	union {
+		struct rectangle rectangle; /** axis-aligned rectangle */
+		struct polygon polygon;     /** convex polygon */
+		struct circle circle;       /** circle */
+	};
+};
+
+/**
+ * @brief Polygons and circles stored structure of arrays for batch collision checks
+ *
+ * The caller owns the arrays, each holding stride entries per vertex. Vertex v of
+ * shape i is found at x[(v * stride) + i], so checking one vertex across many
+ * shapes walks contiguous memory. Polygons are stored counter-clockwise together
+ * with the outward unit normal of each edge, edge v running from vertex v to
+ * vertex v + 1. Circles are stored as their centre with a single vertex.
+ */
+struct convex_set {
+	uint16_t stride;       /** number of shapes the arrays hold */
+	uint8_t *num_vertices; /** vertices of each shape, 1 for circles */
+	map_real_t *x;         /** vertex x coordinates */
+	map_real_t *y;         /** vertex y coordinates */
+	map_real_t *normal_x;  /** edge normal x components */
+	map_real_t *normal_y;  /** edge normal y components */
+	map_real_t *radius;    /** radius of each shape, 0 for polygons */
+};
+
+/**
+ * @brief Arm configuration in whole degrees
+ */
+struct arm_angles {
+	int16_t theta0; /** angle of inclination for arm0 */
+	int16_t theta1; /** angle of inclination for arm1 */
+};
+
+/**
+ * @brief Callback receiving an arm configuration found by an inverse kinematics lookup
+ *
+ * @param[in] angles Configuration found
+ * @param[in] user_data Pointer passed along with the callback
+ *
+ * @retval 0 to carry on, non-zero to stop the lookup and return the value
+ */
+typedef int (*arm_angles_cb_t)(struct arm_angles angles, void *user_data);
+
 /**
  * @brief Determine the endpoint of a segment
  *
  * Given the length of the segment (hypotenuse) and it's angle from the base,
  * calculate the ending x and y coordinate that it occupies
  *
+ * Always computed in double precision, serving as the reference for the
+ * table-driven variant.
+ *
  * @param[in] hypotenuse The length of the segment
  * @param[in] angle_d The angle of the segment from the base in degrees
  * @param[out] x Pointer to x which holds ending x coordinate
@@ -49,6 +321,22 @@ struct rectangle {
  */
 int get_segment_endpoint_trig(double hypotenuse, double angle_d, double *x, double *y);
 
+/**
+ * @brief Determine the endpoint of a segment using the trig lookup table
+ *
+ * Table-driven equivalent of get_segment_endpoint_trig() for angles that are
+ * a whole number of table steps.
+ *
+ * @param[in] hypotenuse The length of the segment
+ * @param[in] angle_steps The angle of the segment from the base in table steps, any sign
+ * @param[out] x Pointer to x which holds ending x coordinate
+ * @param[out] y Pointer to y which holds ending y coordinate
+ *
+ * @retval 0 on success, nonzero on error
+ */
+int get_segment_endpoint_lut(map_real_t hypotenuse, int angle_steps, map_real_t *x,
+			     map_real_t *y);
+
 /**
  * @brief Translate a line segment by a given magnitude
  *
@@ -57,7 +345,7 @@ int get_segment_endpoint_trig(double hypotenuse, double angle_d, double *x, doub
  *
  * @retval The result of the translated vector
  */
-struct segment translate_segment(struct segment segment, double magnitude);
+struct segment translate_segment(struct segment segment, map_real_t magnitude);
 
 /**
  * @brief Determine if two segments intersect
@@ -100,6 +388,9 @@ bool check_segment_segment_intersect(struct segment segment1, struct segment seg
 /**
  * @brief Returns if segment collides with a rectangle
  *
+ * Only crossings of the rectangle edges are reported, so a segment lying wholly
+ * inside the rectangle is not a collision. See check_segment_aabb_collision().
+ *
  * @param[in] segment the subject line segment
  * @param[in] rectangle the rectangle we are concerned of collisions with
  *
@@ -107,9 +398,177 @@ bool check_segment_segment_intersect(struct segment segment1, struct segment seg
  */
 bool check_segment_rectangle_collisions(struct segment segment, struct rectangle rectangle);
 
+/**
+ * @brief Returns if a segment touches an axis-aligned rectangle
+ *
+ * Clips the segment against the X and Y slabs of the rectangle (Liang-Barsky),
+ * stopping at the first slab that leaves nothing of it. A segment wholly inside
+ * the rectangle collides, as does one touching its boundary.
+ *
+ * @param[in] segment the subject line segment
+ * @param[in] rectangle the axis-aligned rectangle to check against
+ *
+ * @return true if collides, false if no collision
+ */
+bool check_segment_aabb_collision(const struct segment *segment, const struct rectangle *rectangle);
+
+/**
+ * @brief Returns if an oriented box around a segment collides with a rectangle
+ *
+ * The box extends half_width either side of the segment and ends flush with its
+ * endpoints, which models an arm link of width 2 * half_width. Unlike sampling
+ * translated copies of the segment, this is exact and cannot step over a thin
+ * obstacle.
+ *
+ * @param[in] segment Centre line of the box
+ * @param[in] half_width Distance the box extends either side of its centre line
+ * @param[in] rectangle The axis-aligned rectangle to check against
+ *
+ * @return true if collides, false if no collision
+ */
+bool check_oriented_box_rectangle_collision(const struct segment *segment, map_real_t half_width,
+					    const struct rectangle *rectangle);
+
+/**
+ * @brief Returns the axis-aligned bounds of a rectangle
+ *
+ * @param[in] rectangle the rectangle to bound
+ * @param[out] min_x Smallest X coordinate covered by the rectangle
+ * @param[out] min_y Smallest Y coordinate covered by the rectangle
+ * @param[out] max_x Largest X coordinate covered by the rectangle
+ * @param[out] max_y Largest Y coordinate covered by the rectangle
+ */
+void get_rectangle_bounds(const struct rectangle *rectangle, map_real_t *min_x, map_real_t *min_y,
+			  map_real_t *max_x, map_real_t *max_y);
+
+/**
+ * @brief Returns the axis-aligned bounds of an obstacle of any shape
+ *
+ * @param[in] obstacle the obstacle to bound
+ * @param[out] aabb Smallest axis-aligned rectangle holding the obstacle
+ */
+void get_obstacle_aabb(const struct obstacle *obstacle, struct rectangle *aabb);
+
+/**
+ * @brief Stores a polygon or circle obstacle in a convex set
+ *
+ * @param[in] set Set to store the shape in
+ * @param[in] idx Index of the shape within the set
+ * @param[in] obstacle Polygon or circle obstacle to store
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the obstacle is a rectangle, or a degenerate polygon or circle
+ */
+int store_convex_shape(struct convex_set *set, int idx, const struct obstacle *obstacle);
+
+/**
+ * @brief Returns if an oriented box around a segment collides with a shape of a convex set
+ *
+ * Same box as check_oriented_box_rectangle_collision(). Polygons are checked with
+ * a separating axis test on the box axes and the polygon edge normals, circles by
+ * their distance to the box.
+ *
+ * @param[in] segment Centre line of the box
+ * @param[in] half_width Distance the box extends either side of its centre line
+ * @param[in] set Set holding the shape
+ * @param[in] idx Index of the shape within the set
+ *
+ * @return true if collides, false if no collision
+ */
+bool check_oriented_box_convex_collision(const struct segment *segment, map_real_t half_width,
+					 const struct convex_set *set, int idx);
+
+/**
+ * @brief Returns if an oriented box around a segment collides with any of several shapes
+ *
+ * Batch form of check_oriented_box_convex_collision(), which sets up the box once
+ * and then tests every selected shape in a single loop.
+ *
+ * @param[in] segment Centre line of the box
+ * @param[in] half_width Distance the box extends either side of its centre line
+ * @param[in] set Set holding the shapes
+ * @param[in] candidates Bitmap selecting the shapes to check, bit i for shape i
+ * @param[in] num_words Number of words in candidates
+ *
+ * @return true if any selected shape collides, false otherwise
+ */
+bool check_oriented_box_convex_set(const struct segment *segment, map_real_t half_width,
+				   const struct convex_set *set, const uint32_t *candidates,
+				   int num_words);
+
+/**
+ * @brief Returns if a point lies inside a shape of a convex set, boundary included
+ *
+ * @param[in] x X coordinate of the point
+ * @param[in] y Y coordinate of the point
+ * @param[in] set Set holding the shape
+ * @param[in] idx Index of the shape within the set
+ *
+ * @return true if the point is covered, false otherwise
+ */
+bool check_point_convex_collision(map_real_t x, map_real_t y, const struct convex_set *set,
+				  int idx);
+
+/**
+ * @brief Returns the angular span a rectangle covers as seen from a point
+ *
+ * The rectangle is grown by margin on all sides before the span is taken, so any
+ * segment starting at (x, y) that passes within margin of the rectangle has a
+ * direction inside the returned span.
+ *
+ * @param[in] x X coordinate of the observing point
+ * @param[in] y Y coordinate of the observing point
+ * @param[in] rectangle the rectangle being observed
+ * @param[in] margin Distance to grow the rectangle by on every side
+ * @param[out] start_d Start of the span in degrees, within [0, 360)
+ * @param[out] width_d Width of the span in degrees, counter-clockwise from start_d
+ *
+ * @retval 0 on success
+ * @retval -EDOM if the point lies inside the grown rectangle (every direction is covered)
+ */
+int get_rectangle_angular_span(map_real_t x, map_real_t y, const struct rectangle *rectangle,
+			       map_real_t margin, double *start_d, double *width_d);
+
+/**
+ * @brief Returns the directions in which a capsule pivoting on its end collides with a rectangle
+ *
+ * The capsule covers every point within radius of the segment from (x, y) of
+ * length len. Equivalently, the segment is checked against the rectangle inflated
+ * by radius with rounded corners. The span is exact rather than sampled.
+ *
+ * @param[in] x X coordinate of the pivot
+ * @param[in] y Y coordinate of the pivot
+ * @param[in] len Length of the segment
+ * @param[in] radius Distance the capsule extends around the segment
+ * @param[in] rectangle the rectangle being checked against
+ * @param[out] start_d Start of the blocked span in degrees, within [0, 360)
+ * @param[out] width_d Width of the blocked span in degrees, counter-clockwise from start_d
+ *
+ * @retval 0 on success
+ * @retval -EDOM if every direction is blocked
+ * @retval -ENOENT if no direction is blocked
+ */
+int get_capsule_blocked_span(map_real_t x, map_real_t y, map_real_t len, map_real_t radius,
+			     const struct rectangle *rectangle, double *start_d, double *width_d);
+
+/**
+ * @brief Returns the distance from a point to the closest point of a rectangle
+ *
+ * @param[in] x X coordinate of the point
+ * @param[in] y Y coordinate of the point
+ * @param[in] rectangle the rectangle to measure to
+ *
+ * @return Distance to the rectangle, 0 if the point lies inside it
+ */
+map_real_t get_point_rectangle_distance(map_real_t x, map_real_t y,
+					const struct rectangle *rectangle);
+
 /**
  * @brief Returns the end X,Y coordinates given two arm angles and origin
  *
+ * Always computed in double precision, serving as the reference for the
+ * table-driven variant.
+ *
  * @param[in] theta0 Axis aligned angle of inclination for arm0
  * @param[in] theta1 Axis aligned angle of inclination for arm1
  * @param[in] len Length of arm
@@ -124,4 +583,52 @@ bool check_segment_rectangle_collisions(struct segment segment, struct rectangle
 int get_arm_endpoint(double theta0, double theta1, double len, double range, double origin_x,
 		     double origin_y, double *end_x, double *end_y);
 
+/**
+ * @brief Returns the end X,Y coordinates given two arm angles using the trig lookup table
+ *
+ * Table-driven equivalent of get_arm_endpoint() for angles that are a whole
+ * number of table steps.
+ *
+ * @param[in] theta0 Axis aligned angle of inclination for arm0 in table steps
+ * @param[in] theta1 Axis aligned angle of inclination for arm1 in table steps
+ * @param[in] len Length of arm
+ * @param[in] origin_x Arm origin X coordinate
+ * @param[in] origin_y Arm origin Y coordinate
+ * @param[out] end_x Arm end X coordinate
+ * @param[out] end_y Arm end Y coordinate
+ *
+ * @retval 0 for success, non-zero otherwise
+ */
+int get_arm_endpoint_lut(int theta0, int theta1, map_real_t len, map_real_t origin_x,
+			 map_real_t origin_y, map_real_t *end_x, map_real_t *end_y);
+
+/**
+ * @brief Returns every arm configuration that places the arm end within a box around X,Y
+ *
+ * Inverse of get_arm_endpoint_lut(). The closed form elbow solutions bound the
+ * angles worth visiting, and each candidate is confirmed with the forward lookup
+ * table, so the result matches a scan of every configuration: those whose endpoint,
+ * rounded up to whole millimetres, is at most tolerance away from X,Y on each axis.
+ *
+ * Angles are the multiples of increment below range. Each solution is passed to
+ * the callback as it is found, in order of theta0 then theta1.
+ *
+ * @param[in] x Target X coordinate
+ * @param[in] y Target Y coordinate
+ * @param[in] tolerance Allowed error along each axis
+ * @param[in] len Length of arm
+ * @param[in] origin_x Arm origin X coordinate
+ * @param[in] origin_y Arm origin Y coordinate
+ * @param[in] range Max rotational degree for arm
+ * @param[in] increment Degrees between neighbouring configurations
+ * @param[in] cb Callback receiving each configuration reaching the box
+ * @param[in] user_data Pointer passed to the callback
+ *
+ * @retval Number of solutions found
+ * @retval Non-zero value returned by the callback, which stopped the lookup
+ */
+int get_arm_inverse_lut(int x, int y, int tolerance, map_real_t len, map_real_t origin_x,
+			map_real_t origin_y, int range, int increment, arm_angles_cb_t cb,
+			void *user_data);
+
 #endif /* MAP_UTILS_H_ */
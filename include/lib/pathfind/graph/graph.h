@@ -15,20 +15,35 @@ struct point {
 	uint16_t y; /**< Y coordinate */
 };
 
+/**
+ * @brief Occupancy grid searched by graph_path()
+ *
+ * Either the cspace itself or a coarser level of it, where each cell covers a
+ * square of 1 << shift cspace cells.
+ */
+struct graph {
+	const uint32_t *occupied; /**< Occupancy bitmap, row_words words per row */
+	const uint32_t *allowed;  /**< Cells the search may enter in the same layout, or NULL */
+	const uint32_t *goal;     /**< Cells ending the search in the same layout */
+	uint16_t dimension;       /**< Number of cells along each side */
+	uint16_t row_words;       /**< Number of words in a bitmap row */
+	uint8_t shift;            /**< Log2 of the cspace cells along each side of a cell */
+};
+
 /**
  * @brief Run the pathfinding algorithm on the supplied graph
  *
- * @param[in] graph Pointer to graph
- * @param[in] start_x Starting X coordinate on graph
- * @param[in] start_y Starting Y coordinate on graph
- * @param[in] sol_mark Marker on graph denoting solution square
- * @param[out] path Pointer to solution path
+ * The search ends on any goal cell. The goal cells of coarser levels may be
+ * entered even if they count as occupied.
+ *
+ * @param[in] graph Graph to search
+ * @param[in] start Starting cell on graph
+ * @param[out] path Cells of graph from start to solution
  * @param[out] num_steps Length of path
  *
  * @retval 0 on success, non-zero otherwise
  */
-int graph_path(const uint8_t (*graph)[CSPACE_DIMENSION], const int start_x, const int start_y,
-	       struct pathfinding_steps path[MAX_NUM_STEPS], int *num_steps,
-	       struct point end_points[SOLUTION_NODES]);
+int graph_path(const struct graph *graph, struct point start, struct point path[MAX_NUM_STEPS],
+	       int *num_steps);
 
 #endif /* APP_GRAPH_H_ */
@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_KINEMATICS_H_
+#define APP_KINEMATICS_H_
+
+#include <lib/common.h>
+#include <lib/map_utils.h>
+
+/**
+ * @brief Prepare the forward kinematics table and its inverse index
+ *
+ * Only does work the first time it is called with CONFIG_PATHFIND_FK_TABLE, and
+ * must be called before the other functions of this file are used concurrently.
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+int kinematics_init(void);
+
+/**
+ * @brief Get the workspace cell the arm end reaches in a configuration
+ *
+ * The arm end position is rounded up to whole millimetres. With
+ * CONFIG_PATHFIND_FK_TABLE this is a table load, otherwise it is computed with
+ * get_arm_endpoint_lut().
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ * @param[out] x X coordinate of the arm end
+ * @param[out] y Y coordinate of the arm end
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+int get_arm_end_cell(int theta0, int theta1, int *x, int *y);
+
+/**
+ * @brief Get the configurations that place the arm end within a box around X,Y
+ *
+ * Passes each configuration whose get_arm_end_cell() is at most tolerance away
+ * from X,Y on each axis to the callback, in no particular order. With
+ * CONFIG_PATHFIND_FK_TABLE the inverse index is probed, otherwise the arm inverse
+ * kinematics are solved with get_arm_inverse_lut().
+ *
+ * @param[in] x Target X coordinate
+ * @param[in] y Target Y coordinate
+ * @param[in] tolerance Allowed error along each axis
+ * @param[in] cb Callback receiving each configuration reaching the box
+ * @param[in] user_data Pointer passed to the callback
+ *
+ * @retval Number of solutions found
+ * @retval Non-zero value returned by the callback, which stopped the lookup
+ */
+int get_arm_goal_configurations(int x, int y, int tolerance, arm_angles_cb_t cb, void *user_data);
+
+#endif /* APP_KINEMATICS_H_ */
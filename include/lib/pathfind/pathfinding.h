@@ -13,11 +13,6 @@
  */
 #define MAX_NUM_STEPS 300
 
-/**
- * @brief Arbitrarily pick solution nodes for heuristic
- */
-#define SOLUTION_NODES 5
-
 /**
  * @brief Struct holding a single step of path
  */
@@ -10,21 +10,96 @@
 #include <lib/common.h>
 #include <lib/map_utils.h>
 
+/**
+ * @brief Upper limit for number of markers overlaid on each of cspace and wspace
+ *
+ * Always holds the start point and the drawn path of one query. End point markers
+ * over the solution region only fill what is left.
+ */
+#define CSPACE_MAX_MARKERS 512
+
+/**
+ * @brief Clearance reported for configurations at least this many steps from any obstacle
+ */
+#define CSPACE_CLEARANCE_MAX UINT8_MAX
+
 /**
  * @brief Add a known obstacle to the environment
+ *
+ * Obstacles added before generate_configuration_space() are picked up by the full
+ * generation. Obstacles added afterwards are applied to the existing cspace
+ * incrementally, rechecking only the configurations the new obstacle can affect.
+ *
+ * Polygons and circles require CONFIG_PATHFIND_CONVEX_OBSTACLES.
+ *
+ * @param[in] obstacle The obstacle to add
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if the shape of the obstacle isn't enabled
+ * @retval -EINVAL if the obstacle is a degenerate polygon or circle
+ * @retval Other non-zero value if the obstacle couldn't be added
+ */
+int add_obstacle(const struct obstacle *obstacle);
+
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES)
+/**
+ * @brief Remove a known obstacle from the environment
+ *
+ * Only the cspace cells that the obstacle was blocking are rechecked, and they
+ * are freed once no other obstacle still blocks them.
+ *
+ * Requires CONFIG_PATHFIND_DYNAMIC_OBSTACLES.
+ *
+ * @param[in] obstacle The obstacle to remove, matching one previously added
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the obstacle is not known
+ */
+int remove_obstacle(const struct obstacle *obstacle);
+
+/**
+ * @brief Move a known obstacle to a new location
+ *
+ * Equivalent to removing the obstacle and adding the destination.
+ *
+ * Requires CONFIG_PATHFIND_DYNAMIC_OBSTACLES.
+ *
+ * @param[in] obstacle The obstacle to move, matching one previously added
+ * @param[in] destination The obstacle at its new location
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the obstacle is not known
  */
-int add_obstacle(const struct rectangle *obstacle);
+int move_obstacle(const struct obstacle *obstacle, const struct obstacle *destination);
+#endif /* CONFIG_PATHFIND_DYNAMIC_OBSTACLES */
 
 /**
  * @brief Generates the configuration space given a workspace map
  *
+ * With CONFIG_PATHFIND_CSPACE_CACHE, a cspace cached for the same obstacles and
+ * arm geometry is loaded instead, and a freshly generated one is cached.
+ *
  * @retval 0 on success, non-zero otherwise
  */
 int generate_configuration_space(void);
 
+/**
+ * @brief Check if a workspace cell is covered by an obstacle
+ *
+ * Answered from the obstacle shapes, without a workspace raster.
+ *
+ * @param[in] x X coordinate in workspace
+ * @param[in] y Y coordinate in workspace
+ *
+ * @retval True if occupied, False otherwise
+ */
+bool workspace_is_occupied(int x, int y);
+
 /**
  * @brief Copy wspace to pointer
  *
+ * Requires CONFIG_PATHFIND_WORKSPACE_RASTER.
+ *
  * @param[out] wspace Pointer to 2D workspace array
  *
  * @retval 0 on success, non-zero otherwise
@@ -32,18 +107,112 @@ int generate_configuration_space(void);
 uint8_t (*get_wspace(void))[WORKSPACE_DIMENSION];
 
 /**
- * @brief Copy cspace to pointer
+ * @brief Get the cspace occupancy bitmap
  *
- * @param[out] cspace Pointer to 2D cspace array
+ * Rows are indexed by theta1 and hold one bit per theta0, set if the
+ * configuration is occupied. Query markers are not part of the bitmap.
  *
- * @retval 0 on success, non-zero otherwise
+ * With CONFIG_PATHFIND_CSPACE_LAZY only the configurations evaluated so far are
+ * set, use cspace_is_occupied() to query any configuration.
+ *
+ * @retval Pointer to 2D cspace bitmap
+ */
+const uint32_t (*get_cspace(void))[CSPACE_ROW_WORDS];
+
+/**
+ * @brief Check if a configuration is occupied
+ *
+ * With CONFIG_PATHFIND_CSPACE_LAZY the configuration is evaluated the first time
+ * it is queried, and the answer is remembered until obstacles change.
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ *
+ * @retval True if occupied, False otherwise
+ */
+bool cspace_is_occupied(int theta0, int theta1);
+
+/**
+ * @brief Get the cspace clearance field
+ *
+ * Holds, per configuration, the number of planner steps to the nearest occupied
+ * configuration, stepping to any of the eight neighbouring cells. Occupied
+ * configurations hold 0 and the distance saturates at CSPACE_CLEARANCE_MAX.
+ * Rows are indexed by theta1 cell, columns by theta0 cell.
+ *
+ * The field is recomputed on first access after the cspace changes, and is only
+ * valid until the next obstacle change.
+ *
+ * Requires CONFIG_PATHFIND_CSPACE_CLEARANCE.
+ *
+ * @retval Pointer to 2D clearance field
+ */
+const uint8_t (*get_cspace_clearance(void))[CSPACE_DIMENSION];
+
+/**
+ * @brief Get the clearance of a configuration
+ *
+ * Requires CONFIG_PATHFIND_CSPACE_CLEARANCE.
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ *
+ * @retval Steps to the nearest occupied configuration, see get_cspace_clearance()
+ */
+uint8_t cspace_clearance(int theta0, int theta1);
+
+/**
+ * @brief Get the marker of a configuration
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ *
+ * @retval Overlay marker if one is set, otherwise OCCUPIED or FREE
+ */
+uint8_t get_cspace_marker(int theta0, int theta1);
+
+/**
+ * @brief Place a marker over a configuration
+ *
+ * Markers live in a per-query overlay and never change the occupancy bitmap.
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ * @param[in] marker Marker to place
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the overlay is full
+ */
+int set_cspace_marker(int theta0, int theta1, uint8_t marker);
+
+/**
+ * @brief Get the marker of a workspace cell
+ *
+ * @param[in] x X coordinate in workspace
+ * @param[in] y Y coordinate in workspace
+ *
+ * @retval Overlay marker if one is set, otherwise OCCUPIED or FREE
+ */
+uint8_t get_wspace_marker(int x, int y);
+
+/**
+ * @brief Place a marker over a workspace cell
+ *
+ * Markers live in a per-query overlay and never change the workspace raster.
+ *
+ * @param[in] x X coordinate in workspace
+ * @param[in] y Y coordinate in workspace
+ * @param[in] marker Marker to place
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the overlay is full
  */
-uint8_t (*get_cspace(void))[CSPACE_DIMENSION];
+int set_wspace_marker(int x, int y, uint8_t marker);
 
 /**
  * @brief Cleanup cspace and reset free markers once finished
  *
- * Iterates over cspace and sets any non-occupied grid square back to free
+ * Discards every marker of the query in both spaces, in constant time.
  */
 void cleanup_cspace(void);
 
@@ -3,6 +3,11 @@
 #include <math.h>
 #include <lib/map_utils.h>
 
+#include <trig_table.h>
+
+BUILD_ASSERT(TRIG_TABLE_STEPS_PER_DEG == CONFIG_MAP_UTILS_TRIG_STEPS_PER_DEG,
+	     "Generated trig table does not match configured resolution");
+
 int get_segment_endpoint_trig(double hypotenuse, double angle_d, double *x, double *y)
 {
 	if (x == NULL || y == NULL) {
@@ -21,18 +26,36 @@ int get_segment_endpoint_trig(double hypotenuse, double angle_d, double *x, doub
 	return 0;
 }
 
-struct segment translate_segment(struct segment segment, double magnitude)
+int get_segment_endpoint_lut(map_real_t hypotenuse, int angle_steps, map_real_t *x,
+			     map_real_t *y)
+{
+	if (x == NULL || y == NULL) {
+		return -EINVAL;
+	}
+
+	angle_steps %= TRIG_TABLE_SIZE;
+	if (angle_steps < 0) {
+		angle_steps += TRIG_TABLE_SIZE;
+	}
+
+	*y = MAP_REAL_MUL(hypotenuse, trig_table_sin[angle_steps]);
+	*x = MAP_REAL_MUL(hypotenuse, trig_table_cos[angle_steps]);
+
+	return 0;
+}
+
+struct segment translate_segment(struct segment segment, map_real_t magnitude)
 {
 	/* Compute the direction vector */
-	double dx = segment.x2 - segment.x1;
-	double dy = segment.y2 - segment.y1;
+	map_real_t dx = segment.x2 - segment.x1;
+	map_real_t dy = segment.y2 - segment.y1;
 
 	/* Compute the length of the vector */
-	double length = sqrt((dx * dx) + (dy * dy));
+	map_real_t length = map_wide_sqrt(MAP_WIDE_MUL(dx, dx) + MAP_WIDE_MUL(dy, dy));
 
 	/* Compute the shift vector */
-	double x_shift = magnitude * (-dy / length);
-	double y_shift = magnitude * (dx / length);
+	map_real_t x_shift = MAP_REAL_MULDIV(magnitude, -dy, length);
+	map_real_t y_shift = MAP_REAL_MULDIV(magnitude, dx, length);
 
 	/* Perform shift */
 	struct segment translatedSeg = {.x1 = segment.x1 + x_shift,
@@ -45,19 +68,22 @@ struct segment translate_segment(struct segment segment, double magnitude)
 
 bool check_segment_segment_intersect(struct segment s1, struct segment s2)
 {
-	double b = (s2.x2 - s2.x1) * (s1.y2 - s1.y1) - (s2.y2 - s2.y1) * (s1.x2 - s1.x1);
-	double a = (s2.x2 - s2.x1) * (s2.y1 - s1.y1) - (s2.y2 - s2.y1) * (s2.x1 - s1.x1);
-	double c = (s1.x2 - s1.x1) * (s2.y1 - s1.y1) - (s1.y2 - s1.y1) * (s2.x1 - s1.x1);
+	map_wide_t b = MAP_WIDE_MUL(s2.x2 - s2.x1, s1.y2 - s1.y1) -
+		       MAP_WIDE_MUL(s2.y2 - s2.y1, s1.x2 - s1.x1);
+	map_wide_t a = MAP_WIDE_MUL(s2.x2 - s2.x1, s2.y1 - s1.y1) -
+		       MAP_WIDE_MUL(s2.y2 - s2.y1, s2.x1 - s1.x1);
+	map_wide_t c = MAP_WIDE_MUL(s1.x2 - s1.x1, s2.y1 - s1.y1) -
+		       MAP_WIDE_MUL(s1.y2 - s1.y1, s2.x1 - s1.x1);
 
 	/* Lines are parallel or collinear */
 	if (b == 0) {
 		/* Collinear check */
 		if (a == 0) {
 			/* Do they overlap, even if they dont 'intersect'? */
-			if (fmax(s1.x1, s1.x2) >= fmin(s2.x1, s2.x2) &&
-			    fmax(s2.x1, s2.x2) >= fmin(s1.x1, s1.x2) &&
-			    fmax(s1.y1, s1.y2) >= fmin(s2.y1, s2.y2) &&
-			    fmax(s2.y1, s2.y2) >= fmin(s1.y1, s1.y2)) {
+			if (MAX(s1.x1, s1.x2) >= MIN(s2.x1, s2.x2) &&
+			    MAX(s2.x1, s2.x2) >= MIN(s1.x1, s1.x2) &&
+			    MAX(s1.y1, s1.y2) >= MIN(s2.y1, s2.y2) &&
+			    MAX(s2.y1, s2.y2) >= MIN(s1.y1, s1.y2)) {
 				return true;
 			}
 			/* Collinear with no overlap */
@@ -67,11 +93,17 @@ bool check_segment_segment_intersect(struct segment s1, struct segment s2)
 		return false;
 	}
 
-	/* Check if they properly intersect or not */
-	double x = a / b;
-	double z = c / b;
+	/*
+	 * Check if they properly intersect or not. Rather than dividing to get
+	 * x = a / b and z = c / b, compare against b directly so that 0 <= x, z <= 1.
+	 */
+	if (b < 0) {
+		a = -a;
+		b = -b;
+		c = -c;
+	}
 
-	if (x >= 0 && x <= 1 && z >= 0 && z <= 1) {
+	if (a >= 0 && a <= b && c >= 0 && c <= b) {
 		/* Intersect at a point */
 		return true;
 	} else {
@@ -93,6 +125,612 @@ bool check_segment_rectangle_collisions(struct segment segment, struct rectangle
 	return collision;
 }
 
+void get_rectangle_bounds(const struct rectangle *rectangle, map_real_t *min_x, map_real_t *min_y,
+			  map_real_t *max_x, map_real_t *max_y)
+{
+	/* Axis aligned, so the bottom edge spans every X and the left edge every Y */
+	*min_x = MIN(rectangle->bottom.x1, rectangle->bottom.x2);
+	*max_x = MAX(rectangle->bottom.x1, rectangle->bottom.x2);
+	*min_y = MIN(rectangle->left.y1, rectangle->left.y2);
+	*max_y = MAX(rectangle->left.y1, rectangle->left.y2);
+}
+
+int get_rectangle_angular_span(map_real_t x, map_real_t y, const struct rectangle *rectangle,
+			       map_real_t margin, double *start_d, double *width_d)
+{
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	get_rectangle_bounds(rectangle, &min_x, &min_y, &max_x, &max_y);
+
+	min_x -= margin;
+	min_y -= margin;
+	max_x += margin;
+	max_y += margin;
+
+	/* Observer inside the grown rectangle can see it in every direction */
+	if (x >= min_x && x <= max_x && y >= min_y && y <= max_y) {
+		return -EDOM;
+	}
+
+	/* Angles are only computed a few times per column, so double is fine here */
+	double corners_x[4] = {MAP_REAL_TO_DOUBLE(min_x - x), MAP_REAL_TO_DOUBLE(max_x - x),
+			       MAP_REAL_TO_DOUBLE(max_x - x), MAP_REAL_TO_DOUBLE(min_x - x)};
+	double corners_y[4] = {MAP_REAL_TO_DOUBLE(min_y - y), MAP_REAL_TO_DOUBLE(min_y - y),
+			       MAP_REAL_TO_DOUBLE(max_y - y), MAP_REAL_TO_DOUBLE(max_y - y)};
+
+	/*
+	 * Measure each corner relative to the direction of the rectangle centre. As the
+	 * observer is outside the rectangle, the span is under 180 degrees and the
+	 * relative angles never wrap.
+	 */
+	double centre = atan2((corners_y[0] + corners_y[2]) / 2, (corners_x[0] + corners_x[1]) / 2) *
+			180.0 / M_PI;
+	double lo = 0;
+	double hi = 0;
+
+	for (int i = 0; i < 4; i++) {
+		double angle = atan2(corners_y[i], corners_x[i]) * 180.0 / M_PI - centre;
+
+		if (angle > 180) {
+			angle -= 360;
+		} else if (angle <= -180) {
+			angle += 360;
+		}
+
+		lo = fmin(lo, angle);
+		hi = fmax(hi, angle);
+	}
+
+	*start_d = fmod(centre + lo + 720, 360);
+	*width_d = hi - lo;
+
+	return 0;
+}
+
+int get_capsule_blocked_span(map_real_t x, map_real_t y, map_real_t len, map_real_t radius,
+			     const struct rectangle *rectangle, double *start_d, double *width_d)
+{
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	get_rectangle_bounds(rectangle, &min_x, &min_y, &max_x, &max_y);
+
+	/* Work relative to the pivot, in double as this runs once per pivot */
+	double l = MAP_REAL_TO_DOUBLE(len);
+	double r = MAP_REAL_TO_DOUBLE(radius);
+	double x0 = MAP_REAL_TO_DOUBLE(min_x - x);
+	double y0 = MAP_REAL_TO_DOUBLE(min_y - y);
+	double x1 = MAP_REAL_TO_DOUBLE(max_x - x);
+	double y1 = MAP_REAL_TO_DOUBLE(max_y - y);
+
+	/* Pivot inside the inflated rectangle is blocked in every direction */
+	if (hypot(fmax(fmax(x0, 0), -x1), fmax(fmax(y0, 0), -y1)) <= r) {
+		return -EDOM;
+	}
+
+	/*
+	 * The blocked directions are those of the inflated rectangle clipped to the
+	 * circle swept by the segment end. Its extreme directions are tangents to a
+	 * rounded corner, or where the swept circle crosses the inflated outline, so
+	 * gather every such point and take the extent of their directions.
+	 */
+	double corners[4][2] = {{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}};
+	double candidates[24];
+	int num_candidates = 0;
+
+	for (int i = 0; i < 4; i++) {
+		double cx = corners[i][0];
+		double cy = corners[i][1];
+		double dist = hypot(cx, cy);
+		double centre = atan2(cy, cx);
+
+		/* Tangents to the rounded corner, if the segment is long enough to touch */
+		if (sqrt((dist * dist) - (r * r)) <= l) {
+			double offset = asin(r / dist);
+
+			candidates[num_candidates++] = centre - offset;
+			candidates[num_candidates++] = centre + offset;
+		}
+
+		/* Swept circle crossing the rounded corner */
+		double cos_offset = ((l * l) + (dist * dist) - (r * r)) / (2 * l * dist);
+
+		if (cos_offset >= -1 && cos_offset <= 1) {
+			double offset = acos(cos_offset);
+
+			candidates[num_candidates++] = centre - offset;
+			candidates[num_candidates++] = centre + offset;
+		}
+	}
+
+	/* Swept circle crossing the straight sides of the inflated rectangle */
+	double sides_y[2] = {y0 - r, y1 + r};
+	double sides_x[2] = {x0 - r, x1 + r};
+
+	for (int i = 0; i < 2; i++) {
+		if (fabs(sides_y[i]) <= l) {
+			double half_chord = sqrt((l * l) - (sides_y[i] * sides_y[i]));
+
+			if (half_chord >= x0 && half_chord <= x1) {
+				candidates[num_candidates++] = atan2(sides_y[i], half_chord);
+			}
+			if (-half_chord >= x0 && -half_chord <= x1) {
+				candidates[num_candidates++] = atan2(sides_y[i], -half_chord);
+			}
+		}
+
+		if (fabs(sides_x[i]) <= l) {
+			double half_chord = sqrt((l * l) - (sides_x[i] * sides_x[i]));
+
+			if (half_chord >= y0 && half_chord <= y1) {
+				candidates[num_candidates++] = atan2(half_chord, sides_x[i]);
+			}
+			if (-half_chord >= y0 && -half_chord <= y1) {
+				candidates[num_candidates++] = atan2(-half_chord, sides_x[i]);
+			}
+		}
+	}
+
+	if (num_candidates == 0) {
+		return -ENOENT;
+	}
+
+	/* The pivot is outside a convex region, so every direction lies within 180 degrees */
+	double lo = 0;
+	double hi = 0;
+
+	for (int i = 1; i < num_candidates; i++) {
+		double angle = (candidates[i] - candidates[0]) * 180.0 / M_PI;
+
+		angle = fmod(angle + 540, 360) - 180;
+		lo = fmin(lo, angle);
+		hi = fmax(hi, angle);
+	}
+
+	*start_d = fmod((candidates[0] * 180.0 / M_PI) + lo + 720, 360);
+	*width_d = hi - lo;
+
+	return 0;
+}
+
+map_real_t get_point_rectangle_distance(map_real_t x, map_real_t y,
+					const struct rectangle *rectangle)
+{
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	get_rectangle_bounds(rectangle, &min_x, &min_y, &max_x, &max_y);
+
+	map_real_t dx = MAX(MAX(min_x - x, 0), x - max_x);
+	map_real_t dy = MAX(MAX(min_y - y, 0), y - max_y);
+
+	return map_wide_sqrt(MAP_WIDE_MUL(dx, dx) + MAP_WIDE_MUL(dy, dy));
+}
+
+/**
+ * @brief Clips the parametric range of a segment against one slab boundary
+ *
+ * The range is held as fractions num / den with a positive denominator, so the
+ * boundary parameter q / p is compared by cross multiplying instead of dividing.
+ *
+ * @param[in] p Rate the segment approaches the boundary, negative when entering
+ * @param[in] q Distance from the segment start to the boundary, negative if outside
+ * @param[in,out] enter_num Numerator of the entry parameter
+ * @param[in,out] enter_den Denominator of the entry parameter
+ * @param[in,out] leave_num Numerator of the exit parameter
+ * @param[in,out] leave_den Denominator of the exit parameter
+ *
+ * @retval True if part of the segment remains, False otherwise
+ */
+static bool clip_slab(map_real_t p, map_real_t q, map_real_t *enter_num, map_real_t *enter_den,
+		      map_real_t *leave_num, map_real_t *leave_den)
+{
+	if (p == 0) {
+		/* Parallel to the boundary, so either wholly inside or wholly outside */
+		return q >= 0;
+	}
+
+	if (p < 0) {
+		/* Entering, keep the latest entry point: t = -q / -p */
+		if (MAP_WIDE_MUL(-q, *enter_den) > MAP_WIDE_MUL(*enter_num, -p)) {
+			*enter_num = -q;
+			*enter_den = -p;
+		}
+	} else {
+		/* Leaving, keep the earliest exit point: t = q / p */
+		if (MAP_WIDE_MUL(q, *leave_den) < MAP_WIDE_MUL(*leave_num, p)) {
+			*leave_num = q;
+			*leave_den = p;
+		}
+	}
+
+	return MAP_WIDE_MUL(*enter_num, *leave_den) <= MAP_WIDE_MUL(*leave_num, *enter_den);
+}
+
+bool check_segment_aabb_collision(const struct segment *segment, const struct rectangle *rectangle)
+{
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	get_rectangle_bounds(rectangle, &min_x, &min_y, &max_x, &max_y);
+
+	map_real_t dx = segment->x2 - segment->x1;
+	map_real_t dy = segment->y2 - segment->y1;
+
+	/* Liang-Barsky: the part of the segment within every slab, starting from [0, 1] */
+	map_real_t enter_num = 0;
+	map_real_t enter_den = MAP_REAL_FROM_INT(1);
+	map_real_t leave_num = MAP_REAL_FROM_INT(1);
+	map_real_t leave_den = MAP_REAL_FROM_INT(1);
+
+	return clip_slab(-dx, segment->x1 - min_x, &enter_num, &enter_den, &leave_num,
+			 &leave_den) &&
+	       clip_slab(dx, max_x - segment->x1, &enter_num, &enter_den, &leave_num,
+			 &leave_den) &&
+	       clip_slab(-dy, segment->y1 - min_y, &enter_num, &enter_den, &leave_num,
+			 &leave_den) &&
+	       clip_slab(dy, max_y - segment->y1, &enter_num, &enter_den, &leave_num, &leave_den);
+}
+
+bool check_oriented_box_rectangle_collision(const struct segment *segment, map_real_t half_width,
+					    const struct rectangle *rectangle)
+{
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	get_rectangle_bounds(rectangle, &min_x, &min_y, &max_x, &max_y);
+
+	map_real_t dx = segment->x2 - segment->x1;
+	map_real_t dy = segment->y2 - segment->y1;
+	map_wide_t len_sq = MAP_WIDE_MUL(dx, dx) + MAP_WIDE_MUL(dy, dy);
+
+	/* A point only collides if it lies inside */
+	if (len_sq == 0) {
+		return check_segment_aabb_collision(segment, rectangle);
+	}
+
+	map_real_t len = map_wide_sqrt(len_sq);
+	map_real_t abs_dx = (dx < 0) ? -dx : dx;
+	map_real_t abs_dy = (dy < 0) ? -dy : dy;
+
+	/*
+	 * Separating axis test on the two rectangle axes, the segment direction and its
+	 * normal. Centres and extents are kept doubled and the segment axes unnormalised,
+	 * so every comparison is between products and nothing is divided.
+	 */
+	map_real_t centre_x = (min_x + max_x) - (segment->x1 + segment->x2);
+	map_real_t centre_y = (min_y + max_y) - (segment->y1 + segment->y2);
+	map_real_t extent_x = max_x - min_x;
+	map_real_t extent_y = max_y - min_y;
+	map_wide_t dist;
+
+	/* X axis */
+	dist = MAP_WIDE_MUL(len, (centre_x < 0) ? -centre_x : centre_x);
+	if (dist > MAP_WIDE_MUL(len, extent_x + abs_dx) + 2 * MAP_WIDE_MUL(half_width, abs_dy)) {
+		return false;
+	}
+
+	/* Y axis */
+	dist = MAP_WIDE_MUL(len, (centre_y < 0) ? -centre_y : centre_y);
+	if (dist > MAP_WIDE_MUL(len, extent_y + abs_dy) + 2 * MAP_WIDE_MUL(half_width, abs_dx)) {
+		return false;
+	}
+
+	/* Centre line touching the rectangle settles it without the remaining axes */
+	if (check_segment_aabb_collision(segment, rectangle)) {
+		return true;
+	}
+
+	/* Along the segment */
+	dist = MAP_WIDE_MUL(centre_x, dx) + MAP_WIDE_MUL(centre_y, dy);
+	if (dist < 0) {
+		dist = -dist;
+	}
+	if (dist > len_sq + MAP_WIDE_MUL(extent_x, abs_dx) + MAP_WIDE_MUL(extent_y, abs_dy)) {
+		return false;
+	}
+
+	/* Across the segment */
+	dist = MAP_WIDE_MUL(centre_y, dx) - MAP_WIDE_MUL(centre_x, dy);
+	if (dist < 0) {
+		dist = -dist;
+	}
+	if (dist > 2 * MAP_WIDE_MUL(half_width, len) + MAP_WIDE_MUL(extent_x, abs_dy) +
+			   MAP_WIDE_MUL(extent_y, abs_dx)) {
+		return false;
+	}
+
+	return true;
+}
+
+void get_obstacle_aabb(const struct obstacle *obstacle, struct rectangle *aabb)
+{
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	switch (obstacle->shape) {
+	case MAP_SHAPE_POLYGON:
+		min_x = max_x = obstacle->polygon.vertices[0].x;
+		min_y = max_y = obstacle->polygon.vertices[0].y;
+		for (int i = 1; i < obstacle->polygon.num_vertices; i++) {
+			min_x = MIN(min_x, obstacle->polygon.vertices[i].x);
+			min_y = MIN(min_y, obstacle->polygon.vertices[i].y);
+			max_x = MAX(max_x, obstacle->polygon.vertices[i].x);
+			max_y = MAX(max_y, obstacle->polygon.vertices[i].y);
+		}
+		break;
+	case MAP_SHAPE_CIRCLE:
+		min_x = obstacle->circle.centre.x - obstacle->circle.radius;
+		min_y = obstacle->circle.centre.y - obstacle->circle.radius;
+		max_x = obstacle->circle.centre.x + obstacle->circle.radius;
+		max_y = obstacle->circle.centre.y + obstacle->circle.radius;
+		break;
+	default:
+		*aabb = obstacle->rectangle;
+		return;
+	}
+
+	*aabb = (struct rectangle){
+		.bottom = {min_x, min_y, max_x, min_y},
+		.top = {min_x, max_y, max_x, max_y},
+		.left = {min_x, min_y, min_x, max_y},
+		.right = {max_x, min_y, max_x, max_y},
+	};
+}
+
+int store_convex_shape(struct convex_set *set, int idx, const struct obstacle *obstacle)
+{
+	if (obstacle->shape == MAP_SHAPE_CIRCLE) {
+		if (obstacle->circle.radius < 0) {
+			return -EINVAL;
+		}
+
+		set->num_vertices[idx] = 1;
+		set->x[idx] = obstacle->circle.centre.x;
+		set->y[idx] = obstacle->circle.centre.y;
+		set->radius[idx] = obstacle->circle.radius;
+		return 0;
+	}
+
+	const struct polygon *polygon = &obstacle->polygon;
+	int n = polygon->num_vertices;
+
+	if (obstacle->shape != MAP_SHAPE_POLYGON || n < 3 || n > MAP_POLYGON_MAX_VERTICES) {
+		return -EINVAL;
+	}
+
+	/* Twice the signed area, positive for a counter-clockwise outline */
+	map_wide_t area = 0;
+
+	for (int i = 0; i < n; i++) {
+		const struct vertex *a = &polygon->vertices[i];
+		const struct vertex *b = &polygon->vertices[(i + 1) % n];
+
+		area += MAP_WIDE_MUL(a->x, b->y) - MAP_WIDE_MUL(b->x, a->y);
+	}
+
+	if (area == 0) {
+		return -EINVAL;
+	}
+
+	for (int i = 0; i < n; i++) {
+		const struct vertex *v = &polygon->vertices[(area > 0) ? i : (n - 1 - i)];
+
+		set->x[(i * set->stride) + idx] = v->x;
+		set->y[(i * set->stride) + idx] = v->y;
+	}
+
+	for (int i = 0; i < n; i++) {
+		int next = (i + 1) % n;
+		int slot = (i * set->stride) + idx;
+		map_real_t edge_x = set->x[(next * set->stride) + idx] - set->x[slot];
+		map_real_t edge_y = set->y[(next * set->stride) + idx] - set->y[slot];
+		map_real_t len = map_wide_sqrt(MAP_WIDE_MUL(edge_x, edge_x) +
+					       MAP_WIDE_MUL(edge_y, edge_y));
+
+		if (len == 0) {
+			return -EINVAL;
+		}
+
+		/* Interior lies to the left of a counter-clockwise edge */
+		set->normal_x[slot] = MAP_REAL_MULDIV(edge_y, MAP_REAL_FROM_INT(1), len);
+		set->normal_y[slot] = MAP_REAL_MULDIV(-edge_x, MAP_REAL_FROM_INT(1), len);
+	}
+
+	set->num_vertices[idx] = n;
+	set->radius[idx] = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Oriented box around a segment, in the frame the convex checks work in
+ */
+struct oriented_box {
+	map_real_t centre_x;   /**< X coordinate of the box centre */
+	map_real_t centre_y;   /**< Y coordinate of the box centre */
+	map_real_t axis_x;     /**< X component of the unit segment direction */
+	map_real_t axis_y;     /**< Y component of the unit segment direction */
+	map_real_t half_len;   /**< Distance the box extends along the segment */
+	map_real_t half_width; /**< Distance the box extends across the segment */
+};
+
+/**
+ * @brief Sets up the oriented box around a segment
+ *
+ * A segment of zero length is kept as a point, as for the rectangle checks.
+ *
+ * @param[in] segment Centre line of the box
+ * @param[in] half_width Distance the box extends either side of its centre line
+ * @param[out] box Box to set up
+ */
+static void get_oriented_box(const struct segment *segment, map_real_t half_width,
+			     struct oriented_box *box)
+{
+	map_real_t dx = segment->x2 - segment->x1;
+	map_real_t dy = segment->y2 - segment->y1;
+	map_real_t len = map_wide_sqrt(MAP_WIDE_MUL(dx, dx) + MAP_WIDE_MUL(dy, dy));
+
+	if (len == 0) {
+		*box = (struct oriented_box){
+			.centre_x = segment->x1,
+			.centre_y = segment->y1,
+			.axis_x = MAP_REAL_FROM_INT(1),
+		};
+		return;
+	}
+
+	box->centre_x = (segment->x1 + segment->x2) / 2;
+	box->centre_y = (segment->y1 + segment->y2) / 2;
+	box->axis_x = MAP_REAL_MULDIV(dx, MAP_REAL_FROM_INT(1), len);
+	box->axis_y = MAP_REAL_MULDIV(dy, MAP_REAL_FROM_INT(1), len);
+	box->half_len = len / 2;
+	box->half_width = half_width;
+}
+
+/**
+ * @brief Returns if an oriented box collides with a shape of a convex set
+ *
+ * @param[in] box Box set up by get_oriented_box()
+ * @param[in] set Set holding the shape
+ * @param[in] idx Index of the shape within the set
+ *
+ * @return true if collides, false if no collision
+ */
+static bool check_box_convex(const struct oriented_box *box, const struct convex_set *set, int idx)
+{
+	int n = set->num_vertices[idx];
+	map_real_t along_lo = 0;
+	map_real_t along_hi = 0;
+	map_real_t across_lo = 0;
+	map_real_t across_hi = 0;
+
+	/* Project every vertex on the box axes, relative to the box centre */
+	for (int i = 0; i < n; i++) {
+		map_real_t rel_x = set->x[(i * set->stride) + idx] - box->centre_x;
+		map_real_t rel_y = set->y[(i * set->stride) + idx] - box->centre_y;
+		map_real_t along =
+			MAP_REAL_MUL(rel_x, box->axis_x) + MAP_REAL_MUL(rel_y, box->axis_y);
+		map_real_t across =
+			MAP_REAL_MUL(rel_y, box->axis_x) - MAP_REAL_MUL(rel_x, box->axis_y);
+
+		if (i == 0) {
+			along_lo = along_hi = along;
+			across_lo = across_hi = across;
+		} else {
+			along_lo = MIN(along_lo, along);
+			along_hi = MAX(along_hi, along);
+			across_lo = MIN(across_lo, across);
+			across_hi = MAX(across_hi, across);
+		}
+	}
+
+	if (n == 1) {
+		/* Circle, measure how far its centre lies outside the box */
+		map_real_t out_along = MAX(MAX(along_lo, -along_lo) - box->half_len, 0);
+		map_real_t out_across = MAX(MAX(across_lo, -across_lo) - box->half_width, 0);
+
+		return MAP_WIDE_MUL(out_along, out_along) + MAP_WIDE_MUL(out_across, out_across) <=
+		       MAP_WIDE_MUL(set->radius[idx], set->radius[idx]);
+	}
+
+	/* Box axes */
+	if (along_lo > box->half_len || along_hi < -box->half_len ||
+	    across_lo > box->half_width || across_hi < -box->half_width) {
+		return false;
+	}
+
+	/* Edge normals, the polygon lies wholly behind each of its edges */
+	for (int i = 0; i < n; i++) {
+		int slot = (i * set->stride) + idx;
+		map_real_t normal_x = set->normal_x[slot];
+		map_real_t normal_y = set->normal_y[slot];
+		map_real_t dist = MAP_REAL_MUL(normal_x, box->centre_x - set->x[slot]) +
+				  MAP_REAL_MUL(normal_y, box->centre_y - set->y[slot]);
+		map_real_t along = MAP_REAL_MUL(normal_x, box->axis_x) +
+				   MAP_REAL_MUL(normal_y, box->axis_y);
+		map_real_t across = MAP_REAL_MUL(normal_y, box->axis_x) -
+				    MAP_REAL_MUL(normal_x, box->axis_y);
+		map_real_t reach = MAP_REAL_MUL(box->half_len, MAX(along, -along)) +
+				   MAP_REAL_MUL(box->half_width, MAX(across, -across));
+
+		if (dist - reach > 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool check_oriented_box_convex_collision(const struct segment *segment, map_real_t half_width,
+					 const struct convex_set *set, int idx)
+{
+	struct oriented_box box;
+
+	get_oriented_box(segment, half_width, &box);
+
+	return check_box_convex(&box, set, idx);
+}
+
+bool check_oriented_box_convex_set(const struct segment *segment, map_real_t half_width,
+				   const struct convex_set *set, const uint32_t *candidates,
+				   int num_words)
+{
+	struct oriented_box box;
+
+	get_oriented_box(segment, half_width, &box);
+
+	for (int w = 0; w < num_words; w++) {
+		for (uint32_t word = candidates[w]; word != 0; word &= word - 1) {
+			if (check_box_convex(&box, set, (w * 32) + find_lsb_set(word) - 1)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool check_point_convex_collision(map_real_t x, map_real_t y, const struct convex_set *set,
+				  int idx)
+{
+	int n = set->num_vertices[idx];
+
+	if (n == 1) {
+		map_real_t dx = x - set->x[idx];
+		map_real_t dy = y - set->y[idx];
+
+		return MAP_WIDE_MUL(dx, dx) + MAP_WIDE_MUL(dy, dy) <=
+		       MAP_WIDE_MUL(set->radius[idx], set->radius[idx]);
+	}
+
+	/* Inside lies left of every counter-clockwise edge, cross products keep it exact */
+	for (int i = 0; i < n; i++) {
+		int slot = (i * set->stride) + idx;
+		int next = (((i + 1) % n) * set->stride) + idx;
+
+		if (MAP_WIDE_MUL(set->x[next] - set->x[slot], y - set->y[slot]) <
+		    MAP_WIDE_MUL(set->y[next] - set->y[slot], x - set->x[slot])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 int get_arm_endpoint(double theta0, double theta1, double len, double range, double origin_x,
 		     double origin_y, double *end_x, double *end_y)
 {
@@ -127,3 +765,182 @@ int get_arm_endpoint(double theta0, double theta1, double len, double range, dou
 
 	return 0;
 }
+
+int get_arm_endpoint_lut(int theta0, int theta1, map_real_t len, map_real_t origin_x,
+			 map_real_t origin_y, map_real_t *end_x, map_real_t *end_y)
+{
+	int ret;
+
+	map_real_t x0_delta;
+	map_real_t y0_delta;
+	map_real_t x1_delta;
+	map_real_t y1_delta;
+
+	ret = get_segment_endpoint_lut(len, theta0, &x0_delta, &y0_delta);
+	if (ret) {
+		return ret;
+	}
+
+	/* Same perpendicular offset as get_arm_endpoint() */
+	ret = get_segment_endpoint_lut(len, theta1 + theta0 - MAP_UTILS_DEG_TO_STEPS(90), &x1_delta,
+				       &y1_delta);
+	if (ret) {
+		return ret;
+	}
+
+	*end_x = origin_x + x0_delta + x1_delta;
+	*end_y = origin_y + y0_delta + y1_delta;
+
+	return 0;
+}
+
+/**
+ * @brief Finds the multiples of increment below range lying on an arc of angles
+ *
+ * @param[in] centre_d Direction of the middle of the arc in degrees
+ * @param[in] half_d Half the width of the arc in degrees
+ * @param[in] range Max rotational degree for arm
+ * @param[in] increment Degrees between neighbouring configurations
+ * @param[out] first First angle of each run, in ascending order
+ * @param[out] last Last angle of each run
+ *
+ * @retval Number of runs, as an arc crossing 0 degrees splits in two
+ */
+static int get_arc_angles(double centre_d, double half_d, int range, int increment,
+			  int first[2], int last[2])
+{
+	int max_angle = ((range - 1) / increment) * increment;
+	int num_runs = 0;
+
+	if (half_d >= 180) {
+		first[0] = 0;
+		last[0] = max_angle;
+		return 1;
+	}
+
+	double lo = fmod(centre_d - half_d, 360);
+
+	if (lo < 0) {
+		lo += 360;
+	}
+
+	/* The part past 360 degrees wraps to the smallest angles, so it comes first */
+	for (int wrap = 360; wrap >= 0; wrap -= 360) {
+		int run_first = MAX((int)ceil((lo - wrap) / increment), 0) * increment;
+		int run_last = MIN((int)floor((lo + (2 * half_d) - wrap) / increment) * increment,
+				   max_angle);
+
+		if (run_first <= run_last) {
+			first[num_runs] = run_first;
+			last[num_runs] = run_last;
+			num_runs++;
+		}
+	}
+
+	return num_runs;
+}
+
+/**
+ * @brief Returns the half width of the arc of directions from a pivot that reach a disc
+ *
+ * @param[in] len Distance from the pivot
+ * @param[in] dist Distance from the pivot to the disc centre
+ * @param[in] radius Radius of the disc
+ *
+ * @retval Half width in degrees, 180 if every direction reaches, negative if none does
+ */
+static double get_reach_half_width(double len, double dist, double radius)
+{
+	if (len + dist <= radius) {
+		return 180;
+	}
+
+	double cos_offset = ((len * len) + (dist * dist) - (radius * radius)) / (2 * len * dist);
+
+	if (cos_offset > 1) {
+		return -1;
+	}
+
+	return acos(MAX(cos_offset, -1)) * 180.0 / M_PI;
+}
+
+int get_arm_inverse_lut(int x, int y, int tolerance, map_real_t len, map_real_t origin_x,
+			map_real_t origin_y, int range, int increment, arm_angles_cb_t cb,
+			void *user_data)
+{
+	int ret;
+	int num_solutions = 0;
+	double l = MAP_REAL_TO_DOUBLE(len);
+
+	/*
+	 * Endpoints rounding up into the box lie within (x - tolerance - 1, x + tolerance],
+	 * so bound the box by a disc with a millimetre to spare for table error.
+	 */
+	double cx = x - 0.5 - MAP_REAL_TO_DOUBLE(origin_x);
+	double cy = y - 0.5 - MAP_REAL_TO_DOUBLE(origin_y);
+	double radius = ((tolerance + 0.5) * M_SQRT2) + 1;
+
+	/* The elbow, a length away from the origin, must be within a length of the disc */
+	double half_d = get_reach_half_width(l, hypot(cx, cy), l + radius);
+	int first0[2];
+	int last0[2];
+	int runs0;
+
+	if (half_d < 0) {
+		return 0;
+	}
+
+	runs0 = get_arc_angles(atan2(cy, cx) * 180.0 / M_PI, half_d, range, increment, first0,
+			       last0);
+
+	for (int run0 = 0; run0 < runs0; run0++) {
+		for (int theta0 = first0[run0]; theta0 <= last0[run0]; theta0 += increment) {
+			double rad0 = theta0 * M_PI / 180.0;
+			double ex = cx - (l * cos(rad0));
+			double ey = cy - (l * sin(rad0));
+			int first1[2];
+			int last1[2];
+			int runs1;
+
+			/* Directions of the second link from the elbow that reach the disc */
+			half_d = get_reach_half_width(l, hypot(ex, ey), radius);
+			if (half_d < 0) {
+				continue;
+			}
+
+			/* Second link direction is theta0 + theta1 - 90 */
+			runs1 = get_arc_angles((atan2(ey, ex) * 180.0 / M_PI) - theta0 + 90, half_d,
+					       range, increment, first1, last1);
+
+			for (int run1 = 0; run1 < runs1; run1++) {
+				for (int theta1 = first1[run1]; theta1 <= last1[run1];
+				     theta1 += increment) {
+					map_real_t end_x;
+					map_real_t end_y;
+
+					ret = get_arm_endpoint_lut(MAP_UTILS_DEG_TO_STEPS(theta0),
+								   MAP_UTILS_DEG_TO_STEPS(theta1),
+								   len, origin_x, origin_y, &end_x,
+								   &end_y);
+					if (ret) {
+						return ret;
+					}
+
+					if (abs(MAP_REAL_CEIL(end_x) - x) > tolerance ||
+					    abs(MAP_REAL_CEIL(end_y) - y) > tolerance) {
+						continue;
+					}
+
+					ret = cb((struct arm_angles){theta0, theta1}, user_data);
+					if (ret) {
+						return ret;
+					}
+
+					num_solutions++;
+				}
+			}
+		}
+	}
+
+	return num_solutions;
+}
@@ -3,7 +3,8 @@
  */
 
 #include <errno.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
@@ -12,9 +13,15 @@
 LOG_MODULE_REGISTER(graph, LOG_LEVEL_INF);
 
 /**
- * @brief Heap used for graphing
+ * @brief Node index marking the absence of a node
  */
-K_HEAP_DEFINE(heap, 16384);
+#define NODE_NONE UINT16_MAX
+
+/**
+ * @brief Whether the open list is ordered by the path cost as well as the distance
+ */
+#define SEARCH_USES_COST                                                                           \
+	(IS_ENABLED(CONFIG_PATHFIND_SEARCH_ASTAR) || IS_ENABLED(CONFIG_PATHFIND_SEARCH_JPS))
 
 /**
  * @brief Node struct used in graphing algorithm
@@ -22,182 +29,768 @@ K_HEAP_DEFINE(heap, 16384);
 struct node {
 	struct point pos;    /**< Node position on graph */
 	uint16_t distance;   /**< Distance from an end-point */
-	struct node *parent; /**< Pointer to parent node */
-	struct node *next;   /**< Pointer to next node in linked-list */
+	uint16_t cost;       /**< Steps from the start node along the parents */
+	uint16_t open_index; /**< Position in the open list, NODE_NONE once removed */
+	uint16_t parent;     /**< Index of the parent node, the start node is its own parent */
 };
 
 /**
- * @brief One bit per cell in graph
+ * @brief Nodes, open list and visited set of a search
+ *
+ * Nodes are allocated from the front of the arena and never freed on their own,
+ * the next search reuses the arena from the start.
+ *
+ * A* moves a queued node when it reaches its cell by a shorter way, so it maps
+ * each cell to its node. A cell is visited when its entry in cell_node names a
+ * node of the current search placed on that cell, so stale entries of earlier
+ * searches need no clearing either. The other searches only need a bitmap of
+ * visited cells, cleared by each search.
  */
-#define BITMAP_SIZE ((CSPACE_DIMENSION * CSPACE_DIMENSION) / 8)
+struct search_context {
+	struct node nodes[CONFIG_PATHFIND_NODE_POOL_SIZE];  /**< Node arena */
+	uint16_t num_nodes;                                 /**< Nodes allocated so far */
+	uint16_t open_list[CONFIG_PATHFIND_OPEN_LIST_SIZE]; /**< Binary min-heap of nodes */
+	uint16_t open_list_len;                             /**< Nodes in the open list */
+#if defined(CONFIG_PATHFIND_SEARCH_ASTAR)
+	uint16_t cell_node[CSPACE_DIMENSION * CSPACE_DIMENSION]; /**< Node of each cell */
+#else
+	uint32_t visited[CSPACE_DIMENSION * CSPACE_ROW_WORDS]; /**< Visited cells, like the graph */
+#endif
+};
 
 /**
- * @brief Visited array
+ * @brief Context of the search in progress
  */
-static uint8_t visited[BITMAP_SIZE] = {0};
+static struct search_context search;
 
 /**
- * @brief Helper function for bitmap
+ * @brief Steps from each cell of the graph being searched to the nearest goal cell
  *
- * @param[in] x X coordinate
- * @param[in] y Y coordinate
+ * Rows of the graph dimension, saturating at UINT8_MAX. Obstacles are ignored, so
+ * this is the Chebyshev distance to the goal set.
+ */
+static uint8_t goal_distance[CSPACE_DIMENSION * CSPACE_DIMENSION];
+
+/**
+ * @brief Check a cell of a graph bitmap
  *
- * @retval Index of bit position
+ * @param[in] bitmap Bitmap laid out like the graph
+ * @param[in] graph Graph being searched
+ * @param[in] pos Cell to check
+ *
+ * @retval True if bit is set, False otherwise
  */
-static inline int get_bit_index(int x, int y)
+static inline bool graph_bit_test(const uint32_t *bitmap, const struct graph *graph,
+				  struct point pos)
 {
-	return y * CSPACE_DIMENSION + x;
+	return (bitmap[(pos.y * graph->row_words) + (pos.x / 32)] >> (pos.x % 32)) & 1U;
 }
 
+#if defined(CONFIG_PATHFIND_SEARCH_ASTAR)
 /**
- * @brief Mark the node as visited
+ * @brief Get the node the current search placed on a cell
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] pos Cell to look up
  *
- * @param[in] x X coordinate
- * @param[in] y Y coordinate
+ * @retval Index of the node, NODE_NONE if the cell hasn't been visited
  */
-static void mark_visited(int x, int y)
+static inline uint16_t get_cell_node(const struct graph *graph, struct point pos)
 {
-	int index = get_bit_index(x, y);
-	visited[index / 8] |= (1 << (index % 8));
+	uint16_t index = search.cell_node[(pos.y * graph->dimension) + pos.x];
+
+	if (index < search.num_nodes && search.nodes[index].pos.x == pos.x &&
+	    search.nodes[index].pos.y == pos.y) {
+		return index;
+	}
+
+	return NODE_NONE;
 }
+#else
 
 /**
- * @brief Check if a node has been visited
- *
- * @param[in] x X coordinate
- * @param[in] y Y coordinate
+ * @brief Set a cell of a graph bitmap
  *
- * @retval True if node visited, False otherwise
+ * @param[in] bitmap Bitmap laid out like the graph
+ * @param[in] graph Graph being searched
+ * @param[in] pos Cell to set
  */
-static bool is_visited(int x, int y)
+static inline void graph_bit_set(uint32_t *bitmap, const struct graph *graph, struct point pos)
 {
-	int index = get_bit_index(x, y);
-	return (visited[index / 8] & (1 << (index % 8))) != 0;
+	bitmap[(pos.y * graph->row_words) + (pos.x / 32)] |= BIT(pos.x % 32);
 }
+#endif /* CONFIG_PATHFIND_SEARCH_ASTAR */
 
 /**
  * @brief Checks if node is valid
  *
- * Checks that the position of the point is within bounds of graph,
- * the position on the graph is not occupied and we haven't visited
- * this node before.
+ * Checks that the position of the point is within bounds of graph
+ * and the position on the graph is not occupied.
+ *
+ * With a lazy cspace, occupancy is evaluated the first time a node is
+ * reached. On coarse graphs the goal cells are always valid.
  *
  * @param[in] pos Point to check
- * @param[in] graph Pointer to graph
+ * @param[in] graph Graph being searched
  *
  * @retval True if valid, False otherwise
  */
-static inline bool is_valid(struct point pos, const uint8_t (*graph)[CSPACE_DIMENSION])
+static inline bool is_valid(struct point pos, const struct graph *graph)
 {
-	return (pos.x > 0 && pos.x < CSPACE_DIMENSION && pos.y > 0 && pos.y < CSPACE_DIMENSION &&
-		graph[pos.y][pos.x] != OCCUPIED && !is_visited(pos.x, pos.y));
+	if (pos.x == 0 || pos.x >= graph->dimension || pos.y == 0 || pos.y >= graph->dimension ||
+	    (graph->allowed && !graph_bit_test(graph->allowed, graph, pos))) {
+		return false;
+	}
+
+	if (IS_ENABLED(CONFIG_PATHFIND_CSPACE_LAZY)) {
+		return !cspace_is_occupied(CSPACE_ANGLE(pos.x), CSPACE_ANGLE(pos.y));
+	}
+
+	return !graph_bit_test(graph->occupied, graph, pos) ||
+	       (graph->shift > 0 && graph_bit_test(graph->goal, graph, pos));
 }
 
 /**
- * @brief Returns the distance to the closest end_point
+ * @brief Fill goal_distance for the graph being searched
+ *
+ * Two passes of a chamfer transform with unit cost to all eight neighbours, the
+ * first carrying distances down and right, the second up and left.
+ *
+ * @param[in] graph Graph being searched
+ */
+static void build_goal_distance(const struct graph *graph)
+{
+	int dim = graph->dimension;
+
+	memset(goal_distance, UINT8_MAX, dim * dim);
+
+	for (int y = 0; y < dim; y++) {
+		for (int w = 0; w < graph->row_words; w++) {
+			for (uint32_t word = graph->goal[(y * graph->row_words) + w]; word != 0;
+			     word &= word - 1) {
+				goal_distance[(y * dim) + (w * 32) + find_lsb_set(word) - 1] = 0;
+			}
+		}
+	}
+
+	for (int y = 0; y < dim; y++) {
+		uint8_t *row = &goal_distance[y * dim];
+		const uint8_t *above = row - dim;
+
+		for (int x = 0; x < dim; x++) {
+			int best = row[x];
+
+			if (x > 0) {
+				best = MIN(best, row[x - 1] + 1);
+			}
+			if (y > 0) {
+				best = MIN(best, above[x] + 1);
+				if (x > 0) {
+					best = MIN(best, above[x - 1] + 1);
+				}
+				if (x < dim - 1) {
+					best = MIN(best, above[x + 1] + 1);
+				}
+			}
+
+			row[x] = best;
+		}
+	}
+
+	for (int y = dim - 1; y >= 0; y--) {
+		uint8_t *row = &goal_distance[y * dim];
+		const uint8_t *below = row + dim;
+
+		for (int x = dim - 1; x >= 0; x--) {
+			int best = row[x];
+
+			if (x < dim - 1) {
+				best = MIN(best, row[x + 1] + 1);
+			}
+			if (y < dim - 1) {
+				best = MIN(best, below[x] + 1);
+				if (x > 0) {
+					best = MIN(best, below[x - 1] + 1);
+				}
+				if (x < dim - 1) {
+					best = MIN(best, below[x + 1] + 1);
+				}
+			}
+
+			row[x] = best;
+		}
+	}
+}
+
+/**
+ * @brief Returns the distance to the closest goal cell
  *
  * Does not take into account obstacles on your way
  *
- * @param[in] curr_x X coordinate of current node
- * @param[in] curr_y Y coordinate of current node
- * @param[in] end_points Array of potential solution end points
+ * @param[in] graph Graph being searched
+ * @param[in] pos Cell to measure from
+ *
+ * @retval Chebyshev distance to the goal set, in cells of the graph
+ */
+static inline int calculate_distance(const struct graph *graph, struct point pos)
+{
+	return goal_distance[(pos.y * graph->dimension) + pos.x];
+}
+
+/**
+ * @brief Number of steps between two cells
+ *
+ * Both joints move at once, so a diagonal step costs the same as a straight one.
+ *
+ * @param[in] a First cell
+ * @param[in] b Second cell
+ *
+ * @retval Chebyshev distance between the cells
+ */
+static inline int step_count(struct point a, struct point b)
+{
+	return MAX(abs(a.x - b.x), abs(a.y - b.y));
+}
+
+/**
+ * @brief Allocate a node on a cell from the arena
+ *
+ * A* and the greedy search mark the cell visited, JPS only once the node is expanded.
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] pos Cell of the node
+ * @param[in] parent Index of the parent node, NODE_NONE for the start node
+ *
+ * @retval Index of the new node
+ * @retval -ENOMEM if the arena is full
+ */
+static int node_alloc(const struct graph *graph, struct point pos, uint16_t parent)
+{
+	if (search.num_nodes == CONFIG_PATHFIND_NODE_POOL_SIZE) {
+		return -ENOMEM;
+	}
+
+	uint16_t index = search.num_nodes++;
+	struct node *node = &search.nodes[index];
+
+	node->pos = pos;
+	node->distance = calculate_distance(graph, pos);
+	node->cost = parent == NODE_NONE
+			     ? 0
+			     : search.nodes[parent].cost + step_count(search.nodes[parent].pos, pos);
+	node->open_index = NODE_NONE;
+	node->parent = parent == NODE_NONE ? index : parent;
+
+#if defined(CONFIG_PATHFIND_SEARCH_ASTAR)
+	search.cell_node[(pos.y * graph->dimension) + pos.x] = index;
+#elif !defined(CONFIG_PATHFIND_SEARCH_JPS)
+	graph_bit_set(search.visited, graph, pos);
+#endif
+
+	return index;
+}
+
+/**
+ * @brief Checks if a node leaves the open list before another
+ *
+ * The greedy search orders nodes by distance alone. A* and JPS order them by the
+ * estimated length of the whole path, and among equal estimates prefers the
+ * node furthest from the start, which is the one closest to the goal. Remaining
+ * ties leave in insertion order, so they are explored first come first served.
+ * Nodes are queued as soon as they are allocated, so their index is their
+ * insertion order.
+ *
+ * @param[in] a Index of the node to check
+ * @param[in] b Index of the node to check against
  *
- * @retval Euclidean distance to closest end-point in absolute terms
+ * @retval True if a comes first, False otherwise
  */
-static int calculate_distance(double curr_x, double curr_y, struct point end_points[SOLUTION_NODES])
+static inline bool node_before(uint16_t a, uint16_t b)
 {
-	int min = INT32_MAX;
-	for (int i = 0; i < SOLUTION_NODES; i++) {
-		int temp;
-		temp = (int)ceil(sqrt(
-			(curr_x - (double)end_points[i].x) * (curr_x - (double)end_points[i].x) +
-			(curr_y - (double)end_points[i].y) * (curr_y - (double)end_points[i].y)));
-		if (temp < min) {
-			min = temp;
+	const struct node *node_a = &search.nodes[a];
+	const struct node *node_b = &search.nodes[b];
+	int estimate_a = node_a->distance;
+	int estimate_b = node_b->distance;
+
+	if (SEARCH_USES_COST) {
+		estimate_a += node_a->cost;
+		estimate_b += node_b->cost;
+
+		if (estimate_a == estimate_b && node_a->cost != node_b->cost) {
+			return node_a->cost > node_b->cost;
 		}
 	}
-	return min;
+
+	return estimate_a < estimate_b || (estimate_a == estimate_b && a < b);
 }
 
 /**
- * @brief Helper to generate possible neighbours
+ * @brief Place a node at a position of the open list
  *
- * @param[in] pos Point to generate neighbours from
- * @param[out] neighbours Generated neighbours in all directions
+ * @param[in] node Index of the node to place
+ * @param[in] index Position in the open list
  */
-static void get_neighbours(struct point pos, struct point neighbours[8])
+static inline void open_list_place(uint16_t node, int index)
 {
-	neighbours[0] = (struct point){pos.x, pos.y + 1};
-	neighbours[1] = (struct point){pos.x, pos.y - 1};
-	neighbours[2] = (struct point){pos.x + 1, pos.y};
-	neighbours[3] = (struct point){pos.x - 1, pos.y};
-	neighbours[4] = (struct point){pos.x + 1, pos.y + 1};
-	neighbours[5] = (struct point){pos.x - 1, pos.y + 1};
-	neighbours[6] = (struct point){pos.x - 1, pos.y - 1};
-	neighbours[7] = (struct point){pos.x + 1, pos.y - 1};
+	search.open_list[index] = node;
+	search.nodes[node].open_index = index;
 }
 
 /**
- * @brief Helper to add a node to linked-list preserving min-distance order
+ * @brief Move a node of the open list towards the root until its parent comes first
  *
- * @param[in] head Pointer to head of linked list
- * @param[in] new_node Pointer to new node to add
+ * @param[in] node Index of the node to move
+ */
+static void open_list_sift_up(uint16_t node)
+{
+	int index = search.nodes[node].open_index;
+
+	while (index > 0) {
+		int parent = (index - 1) / 2;
+
+		if (!node_before(node, search.open_list[parent])) {
+			break;
+		}
+
+		open_list_place(search.open_list[parent], index);
+		index = parent;
+	}
+
+	open_list_place(node, index);
+}
+
+/**
+ * @brief Add a node to the open list, or reorder it after its distance decreased
  *
- * @retval The pointer to the head of the list
+ * @param[in] node Index of the node to add or reorder
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the open list is full
  */
-static struct node *add_ordered(struct node *head, struct node *new_node)
+static int open_list_push(uint16_t node)
 {
-	struct node *prev = NULL;
-	struct node *next = head;
+	if (search.nodes[node].open_index == NODE_NONE) {
+		if (search.open_list_len == CONFIG_PATHFIND_OPEN_LIST_SIZE) {
+			return -ENOMEM;
+		}
 
-	/* Base case, empty head given, new_node is now head */
-	if (!head) {
-		return new_node;
+		open_list_place(node, search.open_list_len++);
 	}
 
-	/* Base case, new_node is now the shortest distance */
-	if (new_node->distance < head->distance) {
-		new_node->next = head;
-		return new_node;
+	open_list_sift_up(node);
+
+	return 0;
+}
+
+/**
+ * @brief Remove the node coming first from the open list
+ *
+ * @retval Index of the removed node, NODE_NONE if the open list is empty
+ */
+static uint16_t open_list_pop(void)
+{
+	if (search.open_list_len == 0) {
+		return NODE_NONE;
 	}
 
-	/* Scan for where new_node slots in */
-	while (new_node->distance >= next->distance) {
-		prev = next;
-		next = next->next;
+	uint16_t first = search.open_list[0];
+	uint16_t last = search.open_list[--search.open_list_len];
+	int len = search.open_list_len;
+	int index = 0;
+
+	/* Move the last node down from the root until both children come after it */
+	while (len > 0) {
+		int child = (2 * index) + 1;
 
-		/* End of list! */
-		if (next == NULL) {
+		if (child >= len) {
 			break;
 		}
+		if (child + 1 < len &&
+		    node_before(search.open_list[child + 1], search.open_list[child])) {
+			child++;
+		}
+		if (!node_before(search.open_list[child], last)) {
+			break;
+		}
+
+		open_list_place(search.open_list[child], index);
+		index = child;
 	}
 
-	/* Insert node at position */
-	new_node->next = next;
-	prev->next = new_node;
+	if (len > 0) {
+		open_list_place(last, index);
+	}
+
+	search.nodes[first].open_index = NODE_NONE;
 
-	/* Return the original head */
-	return head;
+	return first;
 }
 
 /**
- * @brief Inserts a node into the linked-list
+ * @brief Queue a node reached from another
+ *
+ * The greedy search reaches each cell once. A* moves a queued node reached again
+ * by a shorter way onto that way instead. JPS queues the cell again, the first of
+ * its nodes to leave the open list expands it and the others are dropped.
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] pos Cell reached
+ * @param[in] parent Index of the node it was reached from
  *
- * @param[in] head Pointer to head of linked-list
- * @param[in] curr Pointer of the node spawning this action
- * @param[in] end_points Array of potential solutions
+ * @retval 0 on success
+ * @retval -ENOMEM if the node arena or the open list is full
+ */
+static int queue_node(const struct graph *graph, struct point pos, uint16_t parent)
+{
+	int ret;
+
+#if defined(CONFIG_PATHFIND_SEARCH_ASTAR)
+	uint16_t known = get_cell_node(graph, pos);
+
+	if (known != NODE_NONE) {
+		struct node *node = &search.nodes[known];
+		int cost = search.nodes[parent].cost + step_count(search.nodes[parent].pos, pos);
+
+		if (node->open_index != NODE_NONE && cost < node->cost) {
+			node->cost = cost;
+			node->parent = parent;
+			open_list_push(known);
+		}
+		return 0;
+	}
+#else
+	if (graph_bit_test(search.visited, graph, pos)) {
+		return 0;
+	}
+#endif
+
+	/* Marking cells visited prevents cycles */
+	int new = node_alloc(graph, pos, parent);
+	if (new < 0) {
+		LOG_ERR("ERROR Out of nodes!");
+		return new;
+	}
+
+	ret = open_list_push(new);
+	if (ret) {
+		LOG_ERR("ERROR Open list full!");
+		return ret;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_PATHFIND_SEARCH_JPS)
+/**
+ * @brief Checks if a cell may be entered, for coordinates that may leave the graph
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] x X coordinate of the cell
+ * @param[in] y Y coordinate of the cell
+ *
+ * @retval True if valid, False otherwise
+ */
+static inline bool is_free(const struct graph *graph, int x, int y)
+{
+	if (x < 0 || y < 0) {
+		return false;
+	}
+
+	return is_valid((struct point){x, y}, graph);
+}
+
+/**
+ * @brief Get one word of a row of the cells is_valid() accepts
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] y Row of the word, rows outside the graph have no valid cells
+ * @param[in] w Word of the row, words outside the graph have no valid cells
+ *
+ * @retval Bit set for each valid cell
+ */
+static uint32_t valid_word(const struct graph *graph, int y, int w)
+{
+	if (y <= 0 || y >= graph->dimension || w < 0 || w >= graph->row_words) {
+		return 0;
+	}
+
+	int index = (y * graph->row_words) + w;
+	uint32_t word = ~graph->occupied[index];
+
+	if (graph->shift > 0) {
+		word |= graph->goal[index];
+	}
+	if (graph->allowed) {
+		word &= graph->allowed[index];
+	}
+	if (w == 0) {
+		word &= ~1U;
+	}
+	if (w == graph->row_words - 1 && (graph->dimension % 32) != 0) {
+		word &= (1U << (graph->dimension % 32)) - 1;
+	}
+
+	return word;
+}
+
+/**
+ * @brief Jump along a row, a word of cells at a time
+ *
+ * Stops on the first cell that is a goal or has a forced neighbour, which is a
+ * free cell diagonally ahead whose side cell is blocked.
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] from Cell to jump from
+ * @param[in] dx Direction along the row, 1 or -1
+ * @param[out] jump_point Cell the jump stopped on
+ *
+ * @retval True if a jump point was found, False if the row is blocked first
+ */
+static bool jump_row(const struct graph *graph, struct point from, int dx, struct point *jump_point)
+{
+	int y = from.y;
+	int first = from.x + dx;
+
+	for (int w = first / 32; w >= 0 && w < graph->row_words; w += dx) {
+		uint32_t row = valid_word(graph, y, w);
+		uint32_t above = valid_word(graph, y + 1, w);
+		uint32_t below = valid_word(graph, y - 1, w);
+		uint32_t above_ahead;
+		uint32_t below_ahead;
+		uint32_t stop;
+
+		/* Shift the rows either side by one cell, so each bit sees the cell ahead */
+		if (dx > 0) {
+			above_ahead = (above >> 1) | (valid_word(graph, y + 1, w + 1) << 31);
+			below_ahead = (below >> 1) | (valid_word(graph, y - 1, w + 1) << 31);
+		} else {
+			above_ahead = (above << 1) | (valid_word(graph, y + 1, w - 1) >> 31);
+			below_ahead = (below << 1) | (valid_word(graph, y - 1, w - 1) >> 31);
+		}
+
+		stop = ~row | graph->goal[(y * graph->row_words) + w] | (~above & above_ahead) |
+		       (~below & below_ahead);
+
+		/* Ignore the cells behind the first one */
+		if (w == first / 32) {
+			stop &= dx > 0 ? ~0U << (first % 32) : ~0U >> (31 - (first % 32));
+		}
+
+		if (stop == 0) {
+			continue;
+		}
+
+		int x = (w * 32) + (dx > 0 ? find_lsb_set(stop) : find_msb_set(stop)) - 1;
+
+		if (!((row >> (x % 32)) & 1U)) {
+			return false;
+		}
+
+		*jump_point = (struct point){x, y};
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Jump in a straight line
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] from Cell to jump from
+ * @param[in] dx Direction along X, 0 if dy isn't
+ * @param[in] dy Direction along Y, 0 if dx isn't
+ * @param[out] jump_point Cell the jump stopped on
+ *
+ * @retval True if a jump point was found, False if the line is blocked first
+ */
+static bool jump_straight(const struct graph *graph, struct point from, int dx, int dy,
+			  struct point *jump_point)
+{
+	/* Rows of a lazy cspace aren't filled in yet */
+	if (dy == 0 && !IS_ENABLED(CONFIG_PATHFIND_CSPACE_LAZY)) {
+		return jump_row(graph, from, dx, jump_point);
+	}
+
+	for (int x = from.x + dx, y = from.y + dy;; x += dx, y += dy) {
+		if (!is_free(graph, x, y)) {
+			return false;
+		}
+
+		/* Either side, a blocked cell with a free cell ahead of it forces a turn */
+		if (graph_bit_test(graph->goal, graph, (struct point){x, y}) ||
+		    (!is_free(graph, x + dy, y + dx) && is_free(graph, x + dx + dy, y + dy + dx)) ||
+		    (!is_free(graph, x - dy, y - dx) && is_free(graph, x + dx - dy, y + dy - dx))) {
+			*jump_point = (struct point){x, y};
+			return true;
+		}
+	}
+}
+
+/**
+ * @brief Jump diagonally
+ *
+ * Also stops on cells from which a straight jump along either axis of the
+ * direction finds a jump point.
+ *
+ * @param[in] graph Graph being searched
+ * @param[in] from Cell to jump from
+ * @param[in] dx Direction along X, 1 or -1
+ * @param[in] dy Direction along Y, 1 or -1
+ * @param[out] jump_point Cell the jump stopped on
+ *
+ * @retval True if a jump point was found, False if the diagonal is blocked first
+ */
+static bool jump_diagonal(const struct graph *graph, struct point from, int dx, int dy,
+			  struct point *jump_point)
+{
+	struct point straight;
+
+	for (int x = from.x + dx, y = from.y + dy;; x += dx, y += dy) {
+		struct point pos = {x, y};
+
+		if (!is_free(graph, x, y)) {
+			return false;
+		}
+
+		if (graph_bit_test(graph->goal, graph, pos) ||
+		    (!is_free(graph, x - dx, y) && is_free(graph, x - dx, y + dy)) ||
+		    (!is_free(graph, x, y - dy) && is_free(graph, x + dx, y - dy)) ||
+		    jump_straight(graph, pos, dx, 0, &straight) ||
+		    jump_straight(graph, pos, 0, dy, &straight)) {
+			*jump_point = pos;
+			return true;
+		}
+	}
+}
+
+/**
+ * @brief Inserts the jump points reachable from a node into the open list
+ *
+ * Only the directions that no path through the parent reaches as quickly are
+ * followed: straight on, diagonally ahead from a straight move, and around
+ * blocked cells beside the node. The start node follows all eight directions.
+ *
+ * @param[in] curr Index of the node spawning this action
+ * @param[in] graph Pointer to graph array
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the node arena or the open list is full
+ */
+static int add_jump_points(uint16_t curr, const struct graph *graph)
+{
+	int ret;
+	struct point pos = search.nodes[curr].pos;
+	struct point parent = search.nodes[search.nodes[curr].parent].pos;
+	int directions[8][2];
+	int num_directions = 0;
+
+	if (search.nodes[curr].parent == curr) {
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				if (dx != 0 || dy != 0) {
+					directions[num_directions][0] = dx;
+					directions[num_directions][1] = dy;
+					num_directions++;
+				}
+			}
+		}
+	} else {
+		int dx = (pos.x > parent.x) - (pos.x < parent.x);
+		int dy = (pos.y > parent.y) - (pos.y < parent.y);
+
+		directions[num_directions][0] = dx;
+		directions[num_directions][1] = dy;
+		num_directions++;
+
+		if (dx != 0 && dy != 0) {
+			directions[num_directions][0] = dx;
+			directions[num_directions][1] = 0;
+			num_directions++;
+			directions[num_directions][0] = 0;
+			directions[num_directions][1] = dy;
+			num_directions++;
+
+			if (!is_free(graph, pos.x - dx, pos.y)) {
+				directions[num_directions][0] = -dx;
+				directions[num_directions][1] = dy;
+				num_directions++;
+			}
+			if (!is_free(graph, pos.x, pos.y - dy)) {
+				directions[num_directions][0] = dx;
+				directions[num_directions][1] = -dy;
+				num_directions++;
+			}
+		} else {
+			/* The sides of a straight move are (dy, dx) and (-dy, -dx) */
+			if (!is_free(graph, pos.x + dy, pos.y + dx)) {
+				directions[num_directions][0] = dx + dy;
+				directions[num_directions][1] = dy + dx;
+				num_directions++;
+			}
+			if (!is_free(graph, pos.x - dy, pos.y - dx)) {
+				directions[num_directions][0] = dx - dy;
+				directions[num_directions][1] = dy - dx;
+				num_directions++;
+			}
+		}
+	}
+
+	for (int i = 0; i < num_directions; i++) {
+		int dx = directions[i][0];
+		int dy = directions[i][1];
+		struct point jump_point;
+		bool found = dx != 0 && dy != 0 ? jump_diagonal(graph, pos, dx, dy, &jump_point)
+						: jump_straight(graph, pos, dx, dy, &jump_point);
+
+		if (!found) {
+			continue;
+		}
+
+		ret = queue_node(graph, jump_point, curr);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+#else
+
+/**
+ * @brief Helper to generate possible neighbours
+ *
+ * @param[in] pos Point to generate neighbours from
+ * @param[out] neighbours Generated neighbours in all directions
+ */
+static void get_neighbours(struct point pos, struct point neighbours[8])
+{
+	neighbours[0] = (struct point){pos.x, pos.y + 1};
+	neighbours[1] = (struct point){pos.x, pos.y - 1};
+	neighbours[2] = (struct point){pos.x + 1, pos.y};
+	neighbours[3] = (struct point){pos.x - 1, pos.y};
+	neighbours[4] = (struct point){pos.x + 1, pos.y + 1};
+	neighbours[5] = (struct point){pos.x - 1, pos.y + 1};
+	neighbours[6] = (struct point){pos.x - 1, pos.y - 1};
+	neighbours[7] = (struct point){pos.x + 1, pos.y - 1};
+}
+
+/**
+ * @brief Inserts the neighbours of a node into the open list
+ *
+ * @param[in] curr Index of the node spawning this action
  * @param[in] graph Pointer to graph array
  *
- * @retval New head of linked-list
+ * @retval 0 on success
+ * @retval -ENOMEM if the node arena or the open list is full
  */
-static struct node *add_boundary(struct node *head, struct node *curr,
-				 struct point end_points[SOLUTION_NODES],
-				 const uint8_t (*graph)[CSPACE_DIMENSION])
+static int add_boundary(uint16_t curr, const struct graph *graph)
 {
+	int ret;
 	struct point neighbours[8];
 
 	/* Generate all possible positions */
-	get_neighbours(curr->pos, neighbours);
+	get_neighbours(search.nodes[curr].pos, neighbours);
 
 	/* Iterate through each neighbour */
 	for (int i = 0; i < 8; i++) {
@@ -208,129 +801,131 @@ static struct node *add_boundary(struct node *head, struct node *curr,
 			continue;
 		}
 
-		/* Mark node as visited to prevent cycles */
-		mark_visited(new_point.x, new_point.y);
-
-		/* Skip entries that increase our distance */
-		int distance = calculate_distance(new_point.x, new_point.y, end_points);
-
-		/* Create new node and fill pointer */
-		struct node *new = k_heap_alloc(&heap, sizeof(struct node), K_NO_WAIT);
-		if (!new) {
-			LOG_ERR("ERROR Out of memory!");
+		ret = queue_node(graph, new_point, curr);
+		if (ret) {
+			return ret;
 		}
-
-		new->pos = new_point;
-		new->distance = distance;
-		new->parent = curr;
-		head = add_ordered(head, new);
 	}
 
-	return head;
+	return 0;
 }
+#endif /* CONFIG_PATHFIND_SEARCH_JPS */
 
 /**
- * @brief Greedy variant of dijkstra pathfinding algorithm
+ * @brief Best first search of the graph
  *
  * Greedy variant gives us a nice mix between an optimal solution,
  * without explosive memory consumption when there are many dead-ends
  * as the greedy approach via distance calculation keeps us heading in
  * the correct direction most times.
  *
- * @param[in] graph Pointer to graph to perform pathfind on
- * @param[in] start_x Starting X coordinate on graph
- * @param[in] start_y Starting Y coordinate on graph
- * @param[in] end_points Array of potential solution points
- * @param[out] path Pointer to hold found steps to solution
+ * With CONFIG_PATHFIND_SEARCH_ASTAR the search is A* instead, where every step
+ * costs the same as both joints move at once. The Chebyshev distance to the
+ * goal never overestimates that cost, so the path has the fewest steps.
+ *
+ * With CONFIG_PATHFIND_SEARCH_JPS the A* search only queues jump points, and the
+ * straight and diagonal runs between them are filled back in on the path.
+ *
+ * @param[in] graph Graph to perform pathfind on
+ * @param[in] start Starting cell on graph
+ * @param[out] path Pointer to hold found cells to solution
  * @param[out] num_steps Number of steps on path
  *
  * @retval 0 on success, non-zero otherwise
  */
-static int greedy_dijkstra(const uint8_t (*graph)[CSPACE_DIMENSION], const int start_x,
-			   const int start_y, struct point end_points[SOLUTION_NODES],
-			   struct pathfinding_steps path[MAX_NUM_STEPS], int *num_steps)
+static int best_first_search(const struct graph *graph, struct point start,
+			     struct point path[MAX_NUM_STEPS], int *num_steps)
 {
+	int ret;
+
 	LOG_INF("Starting traversal of graph");
 
+	/* Nodes and visited cells of earlier queries are dropped at once */
+	search.num_nodes = 0;
+	search.open_list_len = 0;
+#if !defined(CONFIG_PATHFIND_SEARCH_ASTAR)
+	memset(search.visited, 0, graph->dimension * graph->row_words * sizeof(uint32_t));
+#endif
+
+	build_goal_distance(graph);
+
 	/* Initialize data structures */
-	struct node *head = k_heap_alloc(&heap, sizeof(struct node), K_NO_WAIT);
-	if (!head) {
-		LOG_ERR("ERROR Out of memory!");
-		return -ENOMEM;
+	int head = node_alloc(graph, start, NODE_NONE);
+	if (head < 0) {
+		LOG_ERR("ERROR Out of nodes!");
+		return head;
 	}
 
-	struct point start_p = {.x = start_x, .y = start_y};
+	open_list_push(head);
 
-	head->pos = start_p;
-	head->parent = NULL;
-	head->next = NULL;
-	head->distance = calculate_distance(head->pos.x, head->pos.y, end_points);
+	uint16_t curr;
 
-	struct node *curr = head;
-	while (curr) {
+	/* Once no nodes are left to expand, the loop terminates */
+	while ((curr = open_list_pop()) != NODE_NONE) {
 
-		/* Pop head from linked list */
-		head = head->next;
+#if defined(CONFIG_PATHFIND_SEARCH_JPS)
+		/* The cell was expanded already, by a node that reached it sooner */
+		if (graph_bit_test(search.visited, graph, search.nodes[curr].pos)) {
+			continue;
+		}
+
+		graph_bit_set(search.visited, graph, search.nodes[curr].pos);
+#endif
 
 		/* Check if solution found */
-		if (graph[curr->pos.y][curr->pos.x] == END_POINT) {
+		if (graph_bit_test(graph->goal, graph, search.nodes[curr].pos)) {
 			break;
 		}
 
 		/* Increase your boundary */
-		head = add_boundary(head, curr, end_points, graph);
-
-		/* If add_boundary couldn't add any more nodes, this will equate to NULL and loop
-		 * terminates */
-		curr = head;
+#if defined(CONFIG_PATHFIND_SEARCH_JPS)
+		ret = add_jump_points(curr, graph);
+#else
+		ret = add_boundary(curr, graph);
+#endif
+		if (ret) {
+			return ret;
+		}
 	}
 
-	if (!curr) {
+	if (curr == NODE_NONE) {
 		LOG_ERR("ERROR No path found!");
 		return -1;
 	}
 
-	LOG_INF("Path found!");
-
-	/* Save our solution node */
-	struct node *final = curr;
+	LOG_INF("Path found! (%u nodes)", search.num_nodes);
 
 	/* Reconstruct path */
-	int count = 1;
-	while (curr->pos.x != start_x || curr->pos.y != start_y) {
-		curr = curr->parent;
-		if (count++ >= MAX_NUM_STEPS) {
-			LOG_ERR("Path to solution exceeds MAX_NUM_STEPS: %d", MAX_NUM_STEPS);
-			break;
-		}
+	int count = search.nodes[curr].cost + 1;
+	if (count > MAX_NUM_STEPS) {
+		LOG_ERR("Path to solution exceeds MAX_NUM_STEPS: %d", MAX_NUM_STEPS);
+		return -E2BIG;
 	}
 
-	curr = final;
 	*num_steps = count;
-	struct node *temp;
-	for (int i = count - 1; i >= 0; i--) {
-		path[i].theta0 = curr->pos.x;
-		path[i].theta1 = curr->pos.y;
-		temp = curr;
-		curr = curr->parent;
-		// k_heap_free(&heap, temp);
-	}
+	struct point pos = search.nodes[curr].pos;
+
+	path[count - 1] = pos;
+	for (int i = count - 2; i >= 0; i--) {
+		struct point parent = search.nodes[search.nodes[curr].parent].pos;
 
-	/* Free all remaining memory stuck in linked list */
-	while (head) {
-		temp = head;
-		head = head->next;
-		// k_heap_free(&heap, temp);
+		/* Step towards the parent, which is more than one step away after a jump */
+		pos.x += (parent.x > pos.x) - (parent.x < pos.x);
+		pos.y += (parent.y > pos.y) - (parent.y < pos.y);
+		path[i] = pos;
+
+		if (pos.x == parent.x && pos.y == parent.y) {
+			curr = search.nodes[curr].parent;
+		}
 	}
 
 	LOG_INF("Done calculating path to solution");
 	return 0;
 }
 
-int graph_path(const uint8_t (*graph)[CSPACE_DIMENSION], const int start_x, const int start_y,
-	       struct pathfinding_steps path[MAX_NUM_STEPS], int *num_steps,
-	       struct point end_points[SOLUTION_NODES])
+int graph_path(const struct graph *graph, struct point start, struct point path[MAX_NUM_STEPS],
+	       int *num_steps)
 {
-	LOG_INF("Graphing path from %d\u00B0, %d\u00B0", start_x, start_y);
-	return greedy_dijkstra(graph, start_x, start_y, end_points, path, num_steps);
+	LOG_INF("Graphing path from cell %d, %d (shift %d)", start.x, start.y, graph->shift);
+	return best_first_search(graph, start, path, num_steps);
 }
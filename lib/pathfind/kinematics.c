@@ -0,0 +1,237 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <lib/pathfind/kinematics.h>
+
+LOG_MODULE_REGISTER(kinematics, LOG_LEVEL_INF);
+
+/**
+ * @brief Arm geometry
+ */
+#define ARM_LEN      MAP_REAL_FROM_INT(CONFIG_PATHFIND_ARM_LEN_MM)
+#define ARM_ORIGIN_X MAP_REAL_FROM_INT(CONFIG_PATHFIND_ARM_ORIGIN_X_MM)
+#define ARM_ORIGIN_Y MAP_REAL_FROM_INT(CONFIG_PATHFIND_ARM_ORIGIN_Y_MM)
+
+#if defined(CONFIG_PATHFIND_FK_TABLE)
+
+/**
+ * @brief Number of configurations, numbered theta0 cell major
+ */
+#define FK_NUM_CONFIGS (CSPACE_DIMENSION * CSPACE_DIMENSION)
+
+/**
+ * @brief Lowest Y the arm end can reach
+ */
+#define FK_INDEX_MIN_Y (CONFIG_PATHFIND_ARM_ORIGIN_Y_MM - (2 * CONFIG_PATHFIND_ARM_LEN_MM))
+
+/**
+ * @brief Number of rows of the inverse index, one per Y the arm end can round up to
+ */
+#define FK_INDEX_ROWS ((4 * CONFIG_PATHFIND_ARM_LEN_MM) + 2)
+
+#if FK_NUM_CONFIGS <= UINT16_MAX
+typedef uint16_t fk_config_t;
+#else
+typedef uint32_t fk_config_t;
+#endif
+
+/**
+ * @brief Workspace cell of the arm end
+ */
+struct fk_cell {
+	int16_t x; /**< X coordinate rounded up */
+	int16_t y; /**< Y coordinate rounded up */
+};
+
+/**
+ * @brief Arm end of every configuration
+ */
+static struct fk_cell fk_table[FK_NUM_CONFIGS];
+
+/**
+ * @brief Configurations sorted by the row and then the column of their arm end
+ *
+ * Configurations sharing a cell keep their numbering order.
+ */
+static fk_config_t fk_index[FK_NUM_CONFIGS];
+
+/**
+ * @brief First entry of fk_index for each row, with the total after the last row
+ */
+static fk_config_t fk_row_start[FK_INDEX_ROWS + 1];
+
+/**
+ * @brief Whether the table and index have been built
+ */
+static bool fk_ready;
+
+int kinematics_init(void)
+{
+	int ret;
+
+	if (fk_ready) {
+		return 0;
+	}
+
+	memset(fk_row_start, 0, sizeof(fk_row_start));
+
+	for (int config = 0; config < FK_NUM_CONFIGS; config++) {
+		int theta0 = CSPACE_ANGLE(config / CSPACE_DIMENSION);
+		int theta1 = CSPACE_ANGLE(config % CSPACE_DIMENSION);
+		map_real_t x;
+		map_real_t y;
+
+		ret = get_arm_endpoint_lut(MAP_UTILS_DEG_TO_STEPS(theta0),
+					   MAP_UTILS_DEG_TO_STEPS(theta1), ARM_LEN, ARM_ORIGIN_X,
+					   ARM_ORIGIN_Y, &x, &y);
+		if (ret) {
+			LOG_ERR("ERROR calculating arm endpoint (err: %d)", ret);
+			return ret;
+		}
+
+		fk_table[config].x = MAP_REAL_CEIL(x);
+		fk_table[config].y = MAP_REAL_CEIL(y);
+
+		int row = fk_table[config].y - FK_INDEX_MIN_Y;
+
+		if (row < 0 || row >= FK_INDEX_ROWS) {
+			LOG_ERR("Arm end outside of the inverse index (y: %d)", fk_table[config].y);
+			return -ERANGE;
+		}
+
+		fk_row_start[row + 1]++;
+	}
+
+	for (int row = 0; row < FK_INDEX_ROWS; row++) {
+		fk_row_start[row + 1] += fk_row_start[row];
+	}
+
+	/* Fill each row in numbering order, which leaves each start at the next row */
+	for (int config = 0; config < FK_NUM_CONFIGS; config++) {
+		int row = fk_table[config].y - FK_INDEX_MIN_Y;
+
+		fk_index[fk_row_start[row]++] = config;
+	}
+
+	for (int row = FK_INDEX_ROWS; row > 0; row--) {
+		fk_row_start[row] = fk_row_start[row - 1];
+	}
+	fk_row_start[0] = 0;
+
+	/* Stable insertion sort of each row by column, rows are short */
+	for (int row = 0; row < FK_INDEX_ROWS; row++) {
+		int first = fk_row_start[row];
+		int end = fk_row_start[row + 1];
+
+		for (int i = first + 1; i < end; i++) {
+			fk_config_t config = fk_index[i];
+			int j = i;
+
+			while (j > first && fk_table[fk_index[j - 1]].x > fk_table[config].x) {
+				fk_index[j] = fk_index[j - 1];
+				j--;
+			}
+			fk_index[j] = config;
+		}
+	}
+
+	fk_ready = true;
+
+	LOG_INF("Forward kinematics table ready (%u bytes)",
+		(unsigned int)(sizeof(fk_table) + sizeof(fk_index) + sizeof(fk_row_start)));
+
+	return 0;
+}
+
+int get_arm_end_cell(int theta0, int theta1, int *x, int *y)
+{
+	const struct fk_cell *cell =
+		&fk_table[(CSPACE_CELL(theta0) * CSPACE_DIMENSION) + CSPACE_CELL(theta1)];
+
+	*x = cell->x;
+	*y = cell->y;
+
+	return 0;
+}
+
+int get_arm_goal_configurations(int x, int y, int tolerance, arm_angles_cb_t cb, void *user_data)
+{
+	int ret;
+	int first_row = MAX(y - tolerance - FK_INDEX_MIN_Y, 0);
+	int last_row = MIN(y + tolerance - FK_INDEX_MIN_Y, FK_INDEX_ROWS - 1);
+	int num_solutions = 0;
+
+	for (int row = first_row; row <= last_row; row++) {
+		int lo = fk_row_start[row];
+		int end = fk_row_start[row + 1];
+		int hi = end;
+
+		/* First entry of the row at or right of the box */
+		while (lo < hi) {
+			int mid = lo + ((hi - lo) / 2);
+
+			if (fk_table[fk_index[mid]].x < x - tolerance) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		for (int i = lo; i < end && fk_table[fk_index[i]].x <= x + tolerance; i++) {
+			int config = fk_index[i];
+			struct arm_angles angles = {
+				.theta0 = CSPACE_ANGLE(config / CSPACE_DIMENSION),
+				.theta1 = CSPACE_ANGLE(config % CSPACE_DIMENSION),
+			};
+
+			ret = cb(angles, user_data);
+			if (ret) {
+				return ret;
+			}
+
+			num_solutions++;
+		}
+	}
+
+	return num_solutions;
+}
+
+#else
+
+int kinematics_init(void)
+{
+	return 0;
+}
+
+int get_arm_end_cell(int theta0, int theta1, int *x, int *y)
+{
+	map_real_t end_x;
+	map_real_t end_y;
+	int ret;
+
+	ret = get_arm_endpoint_lut(MAP_UTILS_DEG_TO_STEPS(theta0), MAP_UTILS_DEG_TO_STEPS(theta1),
+				   ARM_LEN, ARM_ORIGIN_X, ARM_ORIGIN_Y, &end_x, &end_y);
+	if (ret) {
+		return ret;
+	}
+
+	*x = MAP_REAL_CEIL(end_x);
+	*y = MAP_REAL_CEIL(end_y);
+
+	return 0;
+}
+
+int get_arm_goal_configurations(int x, int y, int tolerance, arm_angles_cb_t cb, void *user_data)
+{
+	return get_arm_inverse_lut(x, y, tolerance, ARM_LEN, ARM_ORIGIN_X, ARM_ORIGIN_Y,
+				   CONFIG_PATHFIND_ARM_RANGE, CONFIG_PATHFIND_ARM_DEGREE_INC, cb,
+				   user_data);
+}
+
+#endif /* CONFIG_PATHFIND_FK_TABLE */
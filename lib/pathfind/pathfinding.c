@@ -4,10 +4,12 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
 #include <lib/map_utils.h>
+#include <lib/pathfind/kinematics.h>
 #include <lib/pathfind/pathfinding.h>
 #include <lib/pathfind/spaces.h>
 #include <lib/pathfind/graph/graph.h>
@@ -15,81 +17,265 @@
 LOG_MODULE_REGISTER(pathfinding, LOG_LEVEL_INF);
 
 /**
- * @brief Pathfinding workspace
+ * @brief Pathfinding configuration space occupancy
  */
-static uint8_t (*path_wspace)[WORKSPACE_DIMENSION];
+static const uint32_t (*path_cspace)[CSPACE_ROW_WORDS];
 
+#if CONFIG_PATHFIND_PYRAMID_LEVELS > 0
 /**
- * @brief Pathfinding configuration space
+ * @brief Number of cells along each side of a pyramid level
  */
-static uint8_t (*path_cspace)[CSPACE_DIMENSION];
+#define PYRAMID_DIMENSION(level) (((CSPACE_DIMENSION - 1) >> (level)) + 1)
+
+/**
+ * @brief Number of 32-bit words holding one row of a pyramid level
+ */
+#define PYRAMID_ROW_WORDS(level) DIV_ROUND_UP(PYRAMID_DIMENSION(level), 32)
+
+/**
+ * @brief Words of the largest pyramid level bitmap
+ */
+#define PYRAMID_WORDS (PYRAMID_DIMENSION(1) * PYRAMID_ROW_WORDS(1))
+
+/**
+ * @brief Coarser levels of the cspace, level n halving the resolution of level n - 1
+ */
+static uint32_t pyramid[CONFIG_PATHFIND_PYRAMID_LEVELS][PYRAMID_WORDS];
+
+/**
+ * @brief Goal cells of each pyramid level
+ */
+static uint32_t goal_pyramid[CONFIG_PATHFIND_PYRAMID_LEVELS][PYRAMID_WORDS];
+
+/**
+ * @brief Cells of the next finer level the search may enter
+ */
+static uint32_t corridor[CSPACE_DIMENSION * CSPACE_ROW_WORDS];
+#endif
+
+/**
+ * @brief Free cspace cells reaching the goal of the query, in the cspace bitmap layout
+ */
+static uint32_t goal_cells[CSPACE_DIMENSION][CSPACE_ROW_WORDS];
+
+BUILD_ASSERT(CSPACE_MAX_MARKERS > MAX_NUM_STEPS, "Marker overlay too small for a path");
+
+/**
+ * @brief Cells of the path found on the last searched level
+ */
+static struct point path_cells[MAX_NUM_STEPS];
+
+#if CONFIG_PATHFIND_PYRAMID_LEVELS > 0
+/**
+ * @brief Halve the resolution of a bitmap laid out like a graph
+ *
+ * A coarse cell is set if any of the fine cells it covers is.
+ *
+ * @param[out] coarse Bitmap of the level to build
+ * @param[in] level Level to build
+ * @param[in] bits Bitmap of the next finer level
+ * @param[in] fine Next finer level
+ */
+static void pool_pyramid_bitmap(uint32_t *coarse, int level, const uint32_t *bits,
+				const struct graph *fine)
+{
+	memset(coarse, 0, PYRAMID_WORDS * sizeof(uint32_t));
+
+	for (int y = 0; y < fine->dimension; y++) {
+		for (int w = 0; w < fine->row_words; w++) {
+			for (uint32_t word = bits[(y * fine->row_words) + w]; word != 0;
+			     word &= word - 1) {
+				int x = ((w * 32) + find_lsb_set(word) - 1) >> 1;
+
+				coarse[((y >> 1) * PYRAMID_ROW_WORDS(level)) + (x / 32)] |=
+					1U << (x % 32);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Build a pyramid level from the next finer one
+ *
+ * A coarse cell is occupied if any of the fine cells it covers is, and is a goal
+ * if any of them is.
+ *
+ * @param[in] level Level to build
+ * @param[in] fine Next finer level
+ */
+static void build_pyramid_level(int level, const struct graph *fine)
+{
+	pool_pyramid_bitmap(pyramid[level - 1], level, fine->occupied, fine);
+	pool_pyramid_bitmap(goal_pyramid[level - 1], level, fine->goal, fine);
+}
+
+/**
+ * @brief Build the corridor of a finer level around a coarse path
+ *
+ * The corridor holds every fine cell covered by the path, dilated by one coarse
+ * cell so the fine search can cut corners the coarse one could not.
+ *
+ * @param[in] coarse Level the path was found on
+ * @param[in] fine Level the corridor is built for
+ * @param[in] num_steps Length of path_cells
+ */
+static void build_corridor(const struct graph *coarse, const struct graph *fine, int num_steps)
+{
+	memset(corridor, 0, fine->dimension * fine->row_words * sizeof(uint32_t));
+
+	for (int i = 0; i < num_steps; i++) {
+		for (int cy = path_cells[i].y - 1; cy <= path_cells[i].y + 1; cy++) {
+			for (int cx = path_cells[i].x - 1; cx <= path_cells[i].x + 1; cx++) {
+				if (cx < 0 || cx >= coarse->dimension || cy < 0 ||
+				    cy >= coarse->dimension) {
+					continue;
+				}
+
+				for (int y = cy * 2; y < MIN(cy * 2 + 2, fine->dimension); y++) {
+					for (int x = cx * 2; x < MIN(cx * 2 + 2, fine->dimension);
+					     x++) {
+						corridor[(y * fine->row_words) + (x / 32)] |=
+							1U << (x % 32);
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Search the pyramid from the coarsest level down to the cspace
+ *
+ * Each level is only searched inside the corridor of the path found on the
+ * level above it.
+ *
+ * @param[in] cspace Full resolution graph, its allowed cells are set on success
+ * @param[in] start Starting cell of the cspace
+ * @param[out] num_steps Length of path_cells
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int search_pyramid(struct graph *cspace, struct point start, int *num_steps)
+{
+	struct graph levels[CONFIG_PATHFIND_PYRAMID_LEVELS + 1];
+	int ret;
+
+	levels[0] = *cspace;
+
+	for (int level = 1; level <= CONFIG_PATHFIND_PYRAMID_LEVELS; level++) {
+		levels[level] = (struct graph){
+			.occupied = pyramid[level - 1],
+			.allowed = NULL,
+			.goal = goal_pyramid[level - 1],
+			.dimension = PYRAMID_DIMENSION(level),
+			.row_words = PYRAMID_ROW_WORDS(level),
+			.shift = level,
+		};
+		build_pyramid_level(level, &levels[level - 1]);
+	}
+
+	for (int level = CONFIG_PATHFIND_PYRAMID_LEVELS; level > 0; level--) {
+		struct point level_start = {.x = start.x >> level, .y = start.y >> level};
+
+		ret = graph_path(&levels[level], level_start, path_cells, num_steps);
+		if (ret) {
+			return ret;
+		}
+
+		build_corridor(&levels[level], &levels[level - 1], *num_steps);
+		levels[level - 1].allowed = corridor;
+	}
+
+	cspace->allowed = corridor;
+
+	return graph_path(cspace, start, path_cells, num_steps);
+}
+#endif
 
 /**
  * @brief Using routing algorithm, calculate efficient solution to cspace solution space
  *
- * Assumes that path_cspace and path_wspace contain valid data
+ * Assumes that path_cspace contains valid data. With CONFIG_PATHFIND_PYRAMID_LEVELS
+ * the coarse levels are searched first, and the full cspace is searched if the
+ * coarse to fine search finds no path.
  */
 static int calculate_path(struct pathfinding_steps plan[MAX_NUM_STEPS], int *num_steps,
-			  int start_theta0, int start_theta1,
-			  struct point solutions[SOLUTION_NODES])
+			  struct point start)
 {
-	return graph_path(path_cspace, start_theta0, start_theta1, plan, num_steps, solutions);
+	struct graph cspace = {
+		.occupied = &path_cspace[0][0],
+		.allowed = NULL,
+		.goal = &goal_cells[0][0],
+		.dimension = CSPACE_DIMENSION,
+		.row_words = CSPACE_ROW_WORDS,
+		.shift = 0,
+	};
+	int ret;
+
+#if CONFIG_PATHFIND_PYRAMID_LEVELS > 0
+	ret = search_pyramid(&cspace, start, num_steps);
+	if (ret) {
+		LOG_WRN("Coarse to fine search failed, searching full cspace");
+		cspace.allowed = NULL;
+		ret = graph_path(&cspace, start, path_cells, num_steps);
+	}
+#else
+	ret = graph_path(&cspace, start, path_cells, num_steps);
+#endif
+	if (ret) {
+		return ret;
+	}
+
+	for (int i = 0; i < *num_steps; i++) {
+		plan[i].theta0 = CSPACE_ANGLE(path_cells[i].x);
+		plan[i].theta1 = CSPACE_ANGLE(path_cells[i].y);
+	}
+
+	return 0;
 }
 
 /**
- * @brief Mark the solution territory in cspace, given X,Y
+ * @brief Make a configuration reaching the goal a goal cell, if it is free
  *
- * Will scan through cspace, calculating the endpoint
+ * @param[in] angles Configuration reaching the goal
+ * @param[in] user_data Pointer to a bool, set once a goal cell is added
+ *
+ * @retval 0 to carry on with the next configuration
  */
-static int mark_solution_region(int x, int y, int tolerance, struct point solutions[SOLUTION_NODES])
+static int add_goal_cell(struct arm_angles angles, void *user_data)
 {
-	int ret;
+	bool *solution = user_data;
 
+	/*
+	 * If cspace region is not obscured, mark it as potential solution space
+	 */
+	if (!cspace_is_occupied(angles.theta0, angles.theta1)) {
+		cspace_bit_set(goal_cells, CSPACE_CELL(angles.theta0), CSPACE_CELL(angles.theta1));
+		*solution = true;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Mark the solution territory in cspace, given X,Y
+ *
+ * Looks up the configurations reaching the tolerance box around the goal, so only
+ * those are visited. Every free one becomes a goal cell.
+ */
+static int mark_solution_region(int x, int y, int tolerance)
+{
 	/*
 	 * If solution not found, report error
 	 */
 	bool solution = false;
-	int idx = 0;
-
-	double x_end;
-	double y_end;
-
-	for (int theta0 = 0; theta0 < CONFIG_PATHFIND_ARM_RANGE;
-	     theta0 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
-		for (int theta1 = 0; theta1 < CONFIG_PATHFIND_ARM_RANGE;
-		     theta1 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
-			ret = get_arm_endpoint(theta0, theta1, CONFIG_PATHFIND_ARM_LEN_MM,
-					       CONFIG_PATHFIND_ARM_RANGE,
-					       CONFIG_PATHFIND_ARM_ORIGIN_X_MM,
-					       CONFIG_PATHFIND_ARM_ORIGIN_Y_MM, &x_end, &y_end);
-			if (ret) {
-				LOG_ERR("Error calculating arm endpoint! (err: %d)", ret);
-				return ret;
-			}
 
-			x_end = ceil(x_end);
-			y_end = ceil(y_end);
-
-			/*
-			 * If cspace region is not obscured, mark it as potential solution space
-			 */
-			if (((int)x_end >= x - tolerance && (int)x_end <= x + tolerance) &&
-			    ((int)y_end >= y - tolerance && (int)y_end <= y + tolerance)) {
-				if (path_cspace[theta1][theta0] != OCCUPIED) {
-					path_cspace[theta1][theta0] = END_POINT;
-					solution = true;
-
-					/* TODO: Replace this with a distributed approach */
-					if (idx < SOLUTION_NODES) {
-						solutions[idx].x = theta0;
-						solutions[idx].y = theta1;
-						idx++;
-					} else {
-						LOG_INF("Max solution nodes hit");
-					}
-				}
-			}
-		}
+	memset(goal_cells, 0, sizeof(goal_cells));
+
+	int num_goals = get_arm_goal_configurations(x, y, tolerance, add_goal_cell, &solution);
+	if (num_goals < 0) {
+		LOG_ERR("Error solving arm inverse kinematics! (err: %d)", num_goals);
+		return num_goals;
 	}
 
 	if (!solution) {
@@ -100,6 +286,35 @@ static int mark_solution_region(int x, int y, int tolerance, struct point soluti
 	return 0;
 }
 
+/**
+ * @brief Place END_POINT markers over the goal cells on cspace
+ *
+ * The search only uses goal_cells, the markers are just for showing the goal region.
+ * They are placed after the path, and goal cells left over once the overlay is
+ * full stay unmarked.
+ */
+static void mark_goal_markers(void)
+{
+	for (int y = 0; y < CSPACE_DIMENSION; y++) {
+		for (int w = 0; w < CSPACE_ROW_WORDS; w++) {
+			for (uint32_t word = goal_cells[y][w]; word != 0; word &= word - 1) {
+				int theta0 = CSPACE_ANGLE((w * 32) + find_lsb_set(word) - 1);
+				int theta1 = CSPACE_ANGLE(y);
+
+				/* Keep the start point and path markers */
+				if (get_cspace_marker(theta0, theta1) != FREE) {
+					continue;
+				}
+
+				if (set_cspace_marker(theta0, theta1, END_POINT)) {
+					LOG_WRN("Out of cspace markers, solution region partly marked");
+					return;
+				}
+			}
+		}
+	}
+}
+
 int pathfinding_calculate_path(int start_theta0, int start_theta1, int end_x, int end_y,
 			       struct pathfinding_steps plan[MAX_NUM_STEPS], int *num_steps)
 {
@@ -123,63 +338,64 @@ int pathfinding_calculate_path(int start_theta0, int start_theta1, int end_x, in
 	 * 1. Copy over pointers to spaces
 	 */
 	path_cspace = get_cspace();
-	path_wspace = get_wspace();
 
 	/*
 	 * 2. Mark start/endpoint in spaces, if not occupied
 	 */
-	if (path_cspace[start_theta1][start_theta0] != FREE) {
+	if (get_cspace_marker(start_theta0, start_theta1) != FREE) {
 		LOG_ERR("ERROR Provided starting angles are in invalid configuration!");
 		return -EINVAL;
 	}
 
-	path_cspace[start_theta1][start_theta0] = START_POINT;
+	ret = set_cspace_marker(start_theta0, start_theta1, START_POINT);
+	if (ret) {
+		return ret;
+	}
 
-	if (path_wspace[end_y][end_x] != FREE) {
+	if (workspace_is_occupied(end_x, end_y)) {
 		LOG_ERR("ERROR: End coordinates supplied are in occupied space!");
 		return -1;
 	}
 
-	path_wspace[end_y][end_x] = END_POINT;
+	ret = set_wspace_marker(end_x, end_y, END_POINT);
+	if (ret) {
+		return ret;
+	}
 
-	double temp_x;
-	double temp_y;
-	ret = get_arm_endpoint(start_theta0, start_theta1, CONFIG_PATHFIND_ARM_LEN_MM,
-			       CONFIG_PATHFIND_ARM_RANGE, CONFIG_PATHFIND_ARM_ORIGIN_X_MM,
-			       CONFIG_PATHFIND_ARM_ORIGIN_Y_MM, &temp_x, &temp_y);
+	int temp_x;
+	int temp_y;
+	ret = get_arm_end_cell(start_theta0, start_theta1, &temp_x, &temp_y);
 	if (ret) {
 		LOG_ERR("ERROR calculating arm endpoint (err: %d)", ret);
 		return ret;
 	}
 
-	temp_x = ceil(temp_x);
-	temp_y = ceil(temp_y);
-
 	/*
 	 * Check the starting X,Y coordinates are legal
 	 */
-	if ((int)temp_x < 0 || (int)temp_x >= WORKSPACE_DIMENSION || (int)temp_y < 0 ||
-	    (int)temp_x >= WORKSPACE_DIMENSION) {
+	if (temp_x < 0 || temp_x >= WORKSPACE_DIMENSION || temp_y < 0 ||
+	    temp_y >= WORKSPACE_DIMENSION) {
 		LOG_ERR("ERROR: Starting points, given angles, out of wspace range! (x: %d, y: %d)",
-			(int)temp_x, (int)temp_y);
+			temp_x, temp_y);
 		return -1;
 	}
 
-	if (path_wspace[(int)temp_y][(int)temp_x] != FREE) {
+	if (workspace_is_occupied(temp_x, temp_y)) {
 		LOG_ERR("ERROR: Starting coordinates, given angles, are in occupied space! (x: %d, "
 			"y: %d)",
-			(int)temp_y, (int)temp_x);
+			temp_y, temp_x);
 		return -1;
 	}
 
-	path_wspace[(int)temp_y][(int)temp_x] = START_POINT;
-
-	struct point solutions[SOLUTION_NODES];
+	ret = set_wspace_marker(temp_x, temp_y, START_POINT);
+	if (ret) {
+		return ret;
+	}
 
 	/*
 	 * 3. Mark solution territory on cspace
 	 */
-	ret = mark_solution_region(end_x, end_y, CONFIG_PATHFIND_ALLOWABLE_TOLERANCE_MM, solutions);
+	ret = mark_solution_region(end_x, end_y, CONFIG_PATHFIND_ALLOWABLE_TOLERANCE_MM);
 	if (ret) {
 		LOG_ERR("ERROR marking solution region! (err: %d)", ret);
 		return ret;
@@ -189,33 +405,47 @@ int pathfinding_calculate_path(int start_theta0, int start_theta1, int end_x, in
 
 	LOG_INF("Calculating path to solution");
 
-	ret = calculate_path(plan, num_steps, start_theta0, start_theta1, solutions);
+	struct point start = {
+		.x = CSPACE_CELL(start_theta0),
+		.y = CSPACE_CELL(start_theta1),
+	};
+
+	ret = calculate_path(plan, num_steps, start);
 	if (ret) {
 		LOG_ERR("ERROR calculating solution path! (err: %d)", ret);
+		mark_goal_markers();
 		return ret;
 	}
 
 	/*
-	 * 4. Draw solution on cspace
+	 * 4. Draw solution on cspace and wspace, then the solution territory
 	 *
 	 * Don't draw last point to keep end-point marker
 	 */
 	for (int i = 1; i < *num_steps - 1; i++) {
-		path_cspace[plan[i].theta1][plan[i].theta0] = PATH;
+		ret = set_cspace_marker(plan[i].theta0, plan[i].theta1, PATH);
+		if (ret) {
+			LOG_ERR("Out of cspace markers for path");
+			return ret;
+		}
 
-		double x;
-		double y;
-		ret = get_arm_endpoint(plan[i].theta0, plan[i].theta1, CONFIG_PATHFIND_ARM_LEN_MM,
-				       CONFIG_PATHFIND_ARM_RANGE, CONFIG_PATHFIND_ARM_ORIGIN_X_MM,
-				       CONFIG_PATHFIND_ARM_ORIGIN_Y_MM, &x, &y);
+		int x;
+		int y;
+		ret = get_arm_end_cell(plan[i].theta0, plan[i].theta1, &x, &y);
 		if (ret) {
 			LOG_ERR("Error calculating arm endpoint! (err: %d)", ret);
 			return ret;
 		}
 
-		path_wspace[(int)ceil(y)][(int)ceil(x)] = PATH;
+		ret = set_wspace_marker(x, y, PATH);
+		if (ret) {
+			LOG_ERR("Out of wspace markers for path");
+			return ret;
+		}
 	}
 
+	mark_goal_markers();
+
 	LOG_INF("Pathfinding completed successfully, solution staged!");
 
 	return 0;
@@ -4,18 +4,33 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#if defined(CONFIG_PATHFIND_CSPACE_CACHE)
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/crc.h>
+#endif
 
+#include <lib/pathfind/kinematics.h>
 #include <lib/pathfind/spaces.h>
 
+#if defined(CONFIG_PATHFIND_CSPACE_STATIC)
+#include PATHFIND_STATIC_OBSTACLES_H
+#include <static_cspace.h>
+
+BUILD_ASSERT(STATIC_CSPACE_DIMENSION == CSPACE_DIMENSION &&
+		     STATIC_CSPACE_ROW_WORDS == CSPACE_ROW_WORDS,
+	     "Static cspace was generated for a different arm geometry");
+#endif
+
 LOG_MODULE_REGISTER(spaces, LOG_LEVEL_INF);
 
 /**
  * @brief Upper limit for number of obstacles
  */
-#define MAX_NUM_OBJ 10
+#define MAX_NUM_OBJ CONFIG_PATHFIND_MAX_OBSTACLES
 
 /**
  * @brief Number of known obstacles
@@ -24,236 +39,1714 @@ static int num_obstacles;
 
 /**
  * @brief List of obstacles in workspace
+ *
+ * Union bytes outside the shape of each obstacle are kept zeroed.
+ */
+static struct obstacle obstacles[MAX_NUM_OBJ];
+
+/**
+ * @brief Workspace cells covered by an obstacle, inclusive on all sides
+ */
+struct obstacle_bounds {
+	int16_t min_x; /**< Lowest X cell covered */
+	int16_t min_y; /**< Lowest Y cell covered */
+	int16_t max_x; /**< Highest X cell covered */
+	int16_t max_y; /**< Highest Y cell covered */
+};
+
+/**
+ * @brief Bounding box index of obstacles, matching entries of obstacles
+ */
+static struct obstacle_bounds obstacle_bounds[MAX_NUM_OBJ];
+
+/**
+ * @brief Side of a square obstacle grid bucket in mm
+ */
+#define OBSTACLE_GRID_CELL_MM 32
+
+/**
+ * @brief Number of obstacle grid buckets along each side of the workspace
+ */
+#define OBSTACLE_GRID_DIMENSION DIV_ROUND_UP(WORKSPACE_DIMENSION, OBSTACLE_GRID_CELL_MM)
+
+/**
+ * @brief Number of words in a bitmap holding one bit per obstacle
+ */
+#define OBSTACLE_WORDS DIV_ROUND_UP(MAX_NUM_OBJ, 32)
+
+/**
+ * @brief Uniform grid over the workspace, holding which obstacles overlap each bucket
+ *
+ * Obstacles reaching past the workspace are held by the buckets along its edge.
+ */
+static uint32_t obstacle_grid[OBSTACLE_GRID_DIMENSION][OBSTACLE_GRID_DIMENSION][OBSTACLE_WORDS];
+
+#if defined(CONFIG_PATHFIND_CONVEX_OBSTACLES)
+/**
+ * @brief Arrays backing convex_obstacles, indexed like obstacles
+ */
+static uint8_t convex_num_vertices[MAX_NUM_OBJ];
+static map_real_t convex_x[MAP_POLYGON_MAX_VERTICES * MAX_NUM_OBJ];
+static map_real_t convex_y[MAP_POLYGON_MAX_VERTICES * MAX_NUM_OBJ];
+static map_real_t convex_normal_x[MAP_POLYGON_MAX_VERTICES * MAX_NUM_OBJ];
+static map_real_t convex_normal_y[MAP_POLYGON_MAX_VERTICES * MAX_NUM_OBJ];
+static map_real_t convex_radius[MAX_NUM_OBJ];
+
+/**
+ * @brief Polygon and circle obstacles, checked in batches by the SAT kernel
  */
-static struct rectangle obstacles[MAX_NUM_OBJ];
+static struct convex_set convex_obstacles = {
+	.stride = MAX_NUM_OBJ,
+	.num_vertices = convex_num_vertices,
+	.x = convex_x,
+	.y = convex_y,
+	.normal_x = convex_normal_x,
+	.normal_y = convex_normal_y,
+	.radius = convex_radius,
+};
 
+/**
+ * @brief Bitmap of the obstacles that are polygons or circles
+ */
+static uint32_t convex_mask[OBSTACLE_WORDS];
+#endif
+
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
 /**
  * @brief Workspace array
  */
 static uint8_t wspace[WORKSPACE_DIMENSION][WORKSPACE_DIMENSION] = {{FREE}};
+#endif
+
+/**
+ * @brief Configuration space occupancy bitmap
+ *
+ * ARM_RANGE x ARM_RANGE grid of possible configurations for arms, one bit
+ * per configuration. Set bits are occupied.
+ */
+static uint32_t cspace[CSPACE_DIMENSION][CSPACE_ROW_WORDS];
+
+#if defined(CONFIG_PATHFIND_CSPACE_LAZY)
+/**
+ * @brief Configurations evaluated so far, laid out like the cspace bitmap
+ *
+ * The occupancy bit of a configuration is only meaningful once its bit here is set.
+ */
+static uint32_t cspace_known[CSPACE_DIMENSION][CSPACE_ROW_WORDS];
+#endif
+
+/**
+ * @brief Space a scratch marker is placed over
+ */
+enum scratch_space {
+	SCRATCH_CSPACE,
+	SCRATCH_WSPACE,
+};
+
+/**
+ * @brief Marker placed on top of the cspace or wspace for a single query
+ */
+struct scratch_marker {
+	uint16_t epoch; /**< Query the marker belongs to, stale unless it is the current one */
+	uint16_t x;     /**< theta0 in cspace, X coordinate in wspace */
+	uint16_t y;     /**< theta1 in cspace, Y coordinate in wspace */
+	uint8_t space;  /**< Space from enum scratch_space */
+	uint8_t marker; /**< Marker from enum markers */
+};
+
+/**
+ * @brief Log2 of the number of scratch slots
+ */
+#define SCRATCH_SLOT_BITS 11
+
+/**
+ * @brief Number of scratch slots, kept at least twice the markers of both spaces so
+ * probes stay short
+ */
+#define SCRATCH_SLOTS (1 << SCRATCH_SLOT_BITS)
+
+BUILD_ASSERT(SCRATCH_SLOTS >= 4 * CSPACE_MAX_MARKERS, "Scratch layer too small for markers");
+
+/**
+ * @brief Open addressed hash of the START_POINT, END_POINT and PATH markers of a query
+ *
+ * The obstacle maps are never written while planning. Markers of earlier queries are
+ * left in place and ignored, as their epoch no longer matches.
+ */
+static struct scratch_marker scratch[SCRATCH_SLOTS];
+
+/**
+ * @brief Epoch of the current query, never zero so cleared slots are stale
+ */
+static uint16_t scratch_epoch = 1;
+
+/**
+ * @brief Number of markers placed in each space in the current query
+ */
+static int num_scratch_markers[2];
+
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES)
+/**
+ * @brief Reference count type, wide enough for every obstacle plus the workspace bounds
+ */
+#if MAX_NUM_OBJ < UINT8_MAX
+typedef uint8_t cspace_ref_t;
+#else
+typedef uint16_t cspace_ref_t;
+#endif
+
+/**
+ * @brief Number of reasons each cspace cell is occupied
+ *
+ * Each obstacle blocking a configuration holds one reference, as does the arm
+ * reaching outside the workspace. A cell is free again once its count drops to zero.
+ */
+static cspace_ref_t cspace_refs[CSPACE_DIMENSION][CSPACE_DIMENSION];
+#endif
+
+#if defined(CONFIG_PATHFIND_CSPACE_CLEARANCE)
+/**
+ * @brief Steps from each cspace cell to the nearest occupied one
+ *
+ * Indexed like cspace_refs, saturating at CSPACE_CLEARANCE_MAX.
+ */
+static uint8_t cspace_clearance_field[CSPACE_DIMENSION][CSPACE_DIMENSION];
+
+/**
+ * @brief Flag set when the cspace changed since the clearance field was computed
+ */
+static bool clearance_stale = true;
+#endif
 
 /**
- * @brief Configuration space array
+ * @brief Flag set once the full cspace has been generated
  *
- * ARM_RANGE x ARM_RANGE grid of possible configurations for arms
+ * Obstacles added after this point are applied to cspace incrementally.
+ */
+static bool cspace_generated;
+
+/**
+ * @brief Distance the arm may reach either side of its centre line, including clearance
+ */
+#define ARM_MARGIN_MM ((CONFIG_PATHFIND_ARM_WIDTH_MM / 2) + CONFIG_PATHFIND_REQUIRED_CLEARANCE_MM)
+
+/**
+ * @brief Arm dimensions converted to the map_utils numeric backend
  */
-static uint8_t cspace[CSPACE_DIMENSION][CSPACE_DIMENSION] = {{FREE}};
+#define ARM_LEN      MAP_REAL_FROM_INT(CONFIG_PATHFIND_ARM_LEN_MM)
+#define ARM_ORIGIN_X MAP_REAL_FROM_INT(CONFIG_PATHFIND_ARM_ORIGIN_X_MM)
+#define ARM_ORIGIN_Y MAP_REAL_FROM_INT(CONFIG_PATHFIND_ARM_ORIGIN_Y_MM)
 
 /**
- * @brief Checks if arm position collides with environment
+ * @brief Checks if arm segment collides with a single obstacle
  *
- * Verifies against the workspace if the coordinates from global
- * origin to specified coordinates intersect with any obstacles
- * in the workspace.
+ * The segment is treated as a box covering the arm width plus clearance.
  *
- * @param[in] x x coordinate of endpoint of arm
- * @param[in] y y coordinate of endpoint of arm
+ * @param[in] seg Centre line of the arm segment
+ * @param[in] idx Index of the obstacle to check against
  *
  * @retval False if no collisions
  * @retval True is collision
- *
  */
-static bool check_collisions(double orig_x, double orig_y, double end_x, double end_y)
+static bool check_obstacle_collision(const struct segment *seg, int idx)
 {
-	LOG_DBG("Checking collisions for segment spanning from (%f, %f) to (%f, %f)", orig_x,
-		orig_y, end_x, end_y);
+#if defined(CONFIG_PATHFIND_CONVEX_OBSTACLES)
+	if (obstacles[idx].shape != MAP_SHAPE_RECTANGLE) {
+		return check_oriented_box_convex_collision(seg, MAP_REAL_FROM_INT(ARM_MARGIN_MM),
+							   &convex_obstacles, idx);
+	}
+#endif
 
-	struct segment seg = {.x1 = orig_x, .y1 = orig_y, .x2 = end_x, .y2 = end_y};
+	return check_oriented_box_rectangle_collision(seg, MAP_REAL_FROM_INT(ARM_MARGIN_MM),
+						      &obstacles[idx].rectangle);
+}
 
-	/* Iterate through each known object */
-	for (int i = 0; i < num_obstacles; i++) {
+/**
+ * @brief Records a cspace cell becoming blocked or unblocked by an obstacle
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ * @param[in] add True if the cell gains a blocker, False if it loses one
+ */
+static inline void update_cspace_cell(int theta0, int theta1, bool add)
+{
+	int x = CSPACE_CELL(theta0);
+	int y = CSPACE_CELL(theta1);
 
-		/* Translate by the the thickness of our plus clearance arm */
-		for (int mag = -(CONFIG_PATHFIND_ARM_WIDTH_MM / 2) -
-			       CONFIG_PATHFIND_REQUIRED_CLEARANCE_MM;
-		     mag <=
-		     (CONFIG_PATHFIND_ARM_WIDTH_MM / 2) + CONFIG_PATHFIND_REQUIRED_CLEARANCE_MM;
-		     mag +=
-		     (CONFIG_PATHFIND_ARM_WIDTH_MM + (CONFIG_PATHFIND_REQUIRED_CLEARANCE_MM * 2)) /
-		     4) {
-
-			/* Instantly return if a collision is found anywhere along arm width or
-			 * clearance */
-			if (check_segment_rectangle_collisions(translate_segment(seg, mag),
-							       obstacles[i])) {
-				return true;
-			}
-		}
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES)
+	if (add) {
+		cspace_refs[y][x]++;
+		cspace_bit_set(cspace, x, y);
+	} else if (--cspace_refs[y][x] == 0) {
+		cspace_bit_clear(cspace, x, y);
 	}
+#else
+	cspace_bit_set(cspace, x, y);
+#endif
+}
 
-	return false;
+/**
+ * @brief Checks if an angle lies within an angular span
+ *
+ * @param[in] angle_d Angle to check in degrees, any range
+ * @param[in] start_d Start of the span in degrees, within [0, 360)
+ * @param[in] width_d Width of the span in degrees
+ *
+ * @retval True if angle is inside the span, False otherwise
+ */
+static bool angle_in_span(double angle_d, double start_d, double width_d)
+{
+	return fmod(angle_d - start_d + 720, 360) <= width_d;
 }
 
 /**
- * @brief Marks the rectangle in the workspace as occupied
- *
- * @param[in] obstacle The obstacle to be marked
- */
-static void mark_obstacle_in_workspace(const struct rectangle *obstacle)
-{
-	int min_x = (int)fmin(fmin(fmin(obstacle->bottom.x1, obstacle->bottom.x2),
-				   fmin(obstacle->top.x1, obstacle->top.x2)),
-			      fmin(fmin(obstacle->left.x1, obstacle->left.x2),
-				   fmin(obstacle->right.x1, obstacle->right.x2)));
-	int max_x = (int)fmax(fmax(fmax(obstacle->bottom.x1, obstacle->bottom.x2),
-				   fmax(obstacle->top.x1, obstacle->top.x2)),
-			      fmax(fmax(obstacle->left.x1, obstacle->left.x2),
-				   fmax(obstacle->right.x1, obstacle->right.x2)));
-	int min_y = (int)fmin(fmin(fmin(obstacle->bottom.y1, obstacle->bottom.y2),
-				   fmin(obstacle->top.y1, obstacle->top.y2)),
-			      fmin(fmin(obstacle->left.y1, obstacle->left.y2),
-				   fmin(obstacle->right.y1, obstacle->right.y2)));
-	int max_y = (int)fmax(fmax(fmax(obstacle->bottom.y1, obstacle->bottom.y2),
-				   fmax(obstacle->top.y1, obstacle->top.y2)),
-			      fmax(fmax(obstacle->left.y1, obstacle->left.y2),
-				   fmax(obstacle->right.y1, obstacle->right.y2)));
-
-	/* Assumption: That rectangle is axis aligned allows us to do this */
-	for (int y = min_y; y <= max_y; y++) {
-		for (int x = min_x; x <= max_x; x++) {
-			if (x >= 0 && x < CONFIG_PATHFIND_WORKSPACE_SQMM && y >= 0 &&
-			    y < CONFIG_PATHFIND_WORKSPACE_SQMM) {
-				wspace[y][x] = OCCUPIED;
-			}
-		}
+ * @brief Checks if the second arm collides with a single obstacle
+ *
+ * @param[in] elbow_x X coordinate of the elbow
+ * @param[in] elbow_y Y coordinate of the elbow
+ * @param[in] angle Axis aligned angle of inclination for ARM1 in degrees
+ * @param[in] idx Index of the obstacle to check against
+ * @param[out] collision True if the arm collides with the obstacle
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int check_arm1_collision(map_real_t elbow_x, map_real_t elbow_y, int angle, int idx,
+				bool *collision)
+{
+	map_real_t x1_delta;
+	map_real_t y1_delta;
+	int ret;
+
+	ret = get_segment_endpoint_lut(ARM_LEN, MAP_UTILS_DEG_TO_STEPS(angle), &x1_delta,
+				       &y1_delta);
+	if (ret) {
+		LOG_ERR("Error during segment endpoint calculation (err: %d)\n", ret);
+		return ret;
 	}
+
+	struct segment seg = {.x1 = elbow_x,
+			      .y1 = elbow_y,
+			      .x2 = elbow_x + x1_delta,
+			      .y2 = elbow_y + y1_delta};
+
+	*collision = check_obstacle_collision(&seg, idx);
+
+	return 0;
 }
 
-int add_obstacle(const struct rectangle *obstacle)
+/**
+ * @brief Marks or unmarks the theta1 cells of one column blocked by a rectangle
+ *
+ * The directions blocked for a capsule around the second arm form a single span. The
+ * arm's box lies within that capsule, so the span is trimmed from both ends to the
+ * first configurations where the box collides. If the whole rectangle lies within
+ * reach of the arm, the directions blocked for the box form a single span too and
+ * the rest is filled as one run. Otherwise the flat tip of the box can leave a gap
+ * between its two corners, so the remaining configurations are checked one by one.
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] elbow_x X coordinate of the elbow
+ * @param[in] elbow_y Y coordinate of the elbow
+ * @param[in] idx Index of the rectangle to be marked
+ * @param[in] add True to mark the obstacle, False to remove a previously marked one
+ *
+ * @retval 0 on success
+ * @retval -EDOM if the elbow is too close to the rectangle for a single span, every
+ *	   configuration must be checked instead
+ * @retval Other non-zero values on error
+ */
+static int update_blocked_span_in_cspace(int theta0, map_real_t elbow_x, map_real_t elbow_y,
+					 int idx, bool add)
 {
-	if (num_obstacles >= MAX_NUM_OBJ) {
-		return -1;
+	int offset = theta0 - (CONFIG_PATHFIND_ARM_RANGE / 2);
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+	double start;
+	double width;
+	bool collision;
+	int ret;
+
+	ret = get_capsule_blocked_span(elbow_x, elbow_y, ARM_LEN, MAP_REAL_FROM_INT(ARM_MARGIN_MM),
+				       &obstacles[idx].rectangle, &start, &width);
+	if (ret == -ENOENT) {
+		return 0;
+	}
+
+	if (ret) {
+		return ret;
 	}
 
-	mark_obstacle_in_workspace(obstacle);
+	/* Shift the span so that it is measured in theta1, with a degree of slack for rounding */
+	double first = fmod(start - offset + 720, 360);
+	int low = (int)ceil(first) - 1 + 360;
+	int high = (int)floor(first + width) + 1 + 360;
 
-	obstacles[num_obstacles] = *obstacle;
-	num_obstacles++;
+	/* Drop the configurations where only the rounded ends of the capsule reach */
+	for (; low <= high; low++) {
+		int theta1 = low % 360;
+
+		if (theta1 >= CONFIG_PATHFIND_ARM_RANGE ||
+		    (theta1 % CONFIG_PATHFIND_ARM_DEGREE_INC) != 0) {
+			continue;
+		}
+
+		ret = check_arm1_collision(elbow_x, elbow_y, theta1 + offset, idx, &collision);
+		if (ret) {
+			return ret;
+		}
+
+		if (collision) {
+			break;
+		}
+	}
+
+	for (; high > low; high--) {
+		int theta1 = high % 360;
+
+		if (theta1 >= CONFIG_PATHFIND_ARM_RANGE ||
+		    (theta1 % CONFIG_PATHFIND_ARM_DEGREE_INC) != 0) {
+			continue;
+		}
+
+		ret = check_arm1_collision(elbow_x, elbow_y, theta1 + offset, idx, &collision);
+		if (ret) {
+			return ret;
+		}
+
+		if (collision) {
+			break;
+		}
+	}
+
+	get_rectangle_bounds(&obstacles[idx].rectangle, &min_x, &min_y, &max_x, &max_y);
+
+	map_real_t far_x = MAX(elbow_x - min_x, max_x - elbow_x);
+	map_real_t far_y = MAX(elbow_y - min_y, max_y - elbow_y);
+	bool in_reach = MAP_WIDE_MUL(far_x, far_x) + MAP_WIDE_MUL(far_y, far_y) <=
+			MAP_WIDE_MUL(ARM_LEN, ARM_LEN);
+
+	for (int angle = low; angle <= high; angle++) {
+		int theta1 = angle % 360;
+
+		if (theta1 >= CONFIG_PATHFIND_ARM_RANGE ||
+		    (theta1 % CONFIG_PATHFIND_ARM_DEGREE_INC) != 0) {
+			continue;
+		}
+
+		/* Both ends of the run are known to collide */
+		collision = in_reach || angle == low || angle == high ||
+			    (!IS_ENABLED(CONFIG_PATHFIND_DYNAMIC_OBSTACLES) &&
+			     cspace_bit_test(cspace, CSPACE_CELL(theta0), CSPACE_CELL(theta1)));
+		if (!collision) {
+			ret = check_arm1_collision(elbow_x, elbow_y, theta1 + offset, idx,
+						   &collision);
+			if (ret) {
+				return ret;
+			}
+		}
+
+		if (collision) {
+			update_cspace_cell(theta0, theta1, add);
+		}
+	}
 
 	return 0;
 }
 
-int generate_configuration_space()
+/**
+ * @brief Marks or unmarks the cspace cells blocked by a single obstacle
+ *
+ * Only visits the theta0 columns whose first arm can reach the obstacle, and within
+ * the remaining columns only the theta1 cells whose second arm points towards it.
+ * Every visited cell is checked against this obstacle alone. Polygons and circles
+ * are culled by their bounding rectangle.
+ *
+ * @param[in] idx Index of the obstacle to be marked
+ * @param[in] add True to mark the obstacle, False to remove a previously marked one
+ * @param[in] first First theta0 column to update
+ * @param[in] last Column one past the last theta0 column to update
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int update_obstacle_in_columns(int idx, bool add, int first, int last)
 {
-	LOG_INF("Generating Configuration Space!!!");
-
+	struct rectangle aabb;
+	const struct rectangle *obstacle = &aabb;
 	int ret;
 
-	/*
-	 * Run through the entire range of motion for the 2-axis arm
-	 * and record if its a valid placement or not to the configuration space
-	 */
-	for (int theta0 = 0; theta0 < CONFIG_PATHFIND_ARM_RANGE;
+	get_obstacle_aabb(&obstacles[idx], &aabb);
+
+	/* Grow by a millimetre so rounding never culls a colliding cell */
+	map_real_t margin = MAP_REAL_FROM_INT(ARM_MARGIN_MM + 1);
+
+	/* Obstacle is out of reach of the entire arm */
+	if (get_point_rectangle_distance(ARM_ORIGIN_X, ARM_ORIGIN_Y, obstacle) >
+	    MAP_REAL_FROM_INT(2 * CONFIG_PATHFIND_ARM_LEN_MM) + margin) {
+		return 0;
+	}
+
+	double arm0_start;
+	double arm0_width;
+	bool arm0_reach = get_point_rectangle_distance(ARM_ORIGIN_X, ARM_ORIGIN_Y, obstacle) <=
+			  ARM_LEN + margin;
+	bool arm0_all = get_rectangle_angular_span(ARM_ORIGIN_X, ARM_ORIGIN_Y, obstacle, margin,
+						   &arm0_start, &arm0_width) == -EDOM;
+
+	/* Directions of the elbow positions from which the second arm can reach the obstacle */
+	double elbow_start;
+	double elbow_width;
+	bool elbow_all = get_rectangle_angular_span(ARM_ORIGIN_X, ARM_ORIGIN_Y, obstacle,
+						    ARM_LEN + margin, &elbow_start,
+						    &elbow_width) == -EDOM;
+
+	for (int theta0 = ROUND_UP(first, CONFIG_PATHFIND_ARM_DEGREE_INC); theta0 < last;
 	     theta0 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
 
-		LOG_INF("Generating... %d%% complete", (theta0 * 100) / 180);
+		bool arm0_hit =
+			arm0_reach && (arm0_all || angle_in_span(theta0, arm0_start, arm0_width));
+
+		/* Neither arm can reach the obstacle from this column */
+		if (!arm0_hit && !(elbow_all || angle_in_span(theta0, elbow_start, elbow_width))) {
+			continue;
+		}
 
-		double x0_delta;
-		double y0_delta;
+		map_real_t x0_delta;
+		map_real_t y0_delta;
 
-		/*
-		 * This gets the endpoint assuming origin of 0
-		 */
-		ret = get_segment_endpoint_trig(CONFIG_PATHFIND_ARM_LEN_MM, (double)theta0,
-						&x0_delta, &y0_delta);
+		ret = get_segment_endpoint_lut(ARM_LEN, MAP_UTILS_DEG_TO_STEPS(theta0), &x0_delta,
+					       &y0_delta);
 		if (ret) {
 			LOG_ERR("Error during segment endpoint calculation (err: %d)\n", ret);
 			return ret;
 		}
 
-		double x0_endpoint = CONFIG_PATHFIND_ARM_ORIGIN_X_MM + x0_delta;
-		double y0_endpoint = CONFIG_PATHFIND_ARM_ORIGIN_Y_MM + y0_delta;
+		map_real_t x0_endpoint = ARM_ORIGIN_X + x0_delta;
+		map_real_t y0_endpoint = ARM_ORIGIN_Y + y0_delta;
 
-		/*
-		 * Calculate collisions in workspace
-		 */
-		if (check_collisions(CONFIG_PATHFIND_ARM_ORIGIN_X_MM,
-				     CONFIG_PATHFIND_ARM_ORIGIN_Y_MM, x0_endpoint, y0_endpoint)) {
-			for (int j = 0; j < CONFIG_PATHFIND_ARM_RANGE;
-			     j += CONFIG_PATHFIND_ARM_DEGREE_INC) {
-				LOG_DBG("Recording collision at angles: (theta0: %d, theta1: %d)",
-					theta0, j);
-				cspace[j][theta0] = OCCUPIED;
+		if (arm0_hit) {
+			struct segment seg = {.x1 = ARM_ORIGIN_X,
+					      .y1 = ARM_ORIGIN_Y,
+					      .x2 = x0_endpoint,
+					      .y2 = y0_endpoint};
+
+			if (check_obstacle_collision(&seg, idx)) {
+				for (int j = 0; j < CONFIG_PATHFIND_ARM_RANGE;
+				     j += CONFIG_PATHFIND_ARM_DEGREE_INC) {
+					update_cspace_cell(theta0, j, add);
+				}
+				continue;
 			}
-			continue;
 		}
 
-		/*
-		 * Our model does not rotate the axis, instead assume theta1 = 0 is
-		 * perpendicular to theta0 since each arm is in series with each other.
-		 */
-		for (int theta1 = 0; theta1 < CONFIG_PATHFIND_ARM_RANGE;
-		     theta1 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
+		/* Second arm can't reach the obstacle from this elbow position */
+		if (get_point_rectangle_distance(x0_endpoint, y0_endpoint, obstacle) >
+		    ARM_LEN + margin) {
+			continue;
+		}
 
-			double x1_delta;
-			double y1_delta;
+		/* The blocked span is only exact for rectangles */
+		if (IS_ENABLED(CONFIG_PATHFIND_CSPACE_ANALYTIC) &&
+		    obstacles[idx].shape == MAP_SHAPE_RECTANGLE) {
+			ret = update_blocked_span_in_cspace(theta0, x0_endpoint, y0_endpoint, idx,
+							    add);
+			if (ret == 0) {
+				continue;
+			}
 
-			ret = get_segment_endpoint_trig(
-				CONFIG_PATHFIND_ARM_LEN_MM,
-				(double)theta1 + (theta0 - (CONFIG_PATHFIND_ARM_RANGE / 2)),
-				&x1_delta, &y1_delta);
-			if (ret) {
-				LOG_ERR("Error during segment endpoint calculation (err: %d)\n",
-					ret);
+			/* The elbow is too close to the rectangle, check each configuration */
+			if (ret != -EDOM) {
 				return ret;
 			}
+		}
 
-			double x1_endpoint = x0_endpoint + x1_delta;
-			double y1_endpoint = y0_endpoint + y1_delta;
+		double arm1_start;
+		double arm1_width;
+		bool arm1_all = get_rectangle_angular_span(x0_endpoint, y0_endpoint, obstacle,
+							   margin, &arm1_start,
+							   &arm1_width) == -EDOM;
 
-			/*
-			 * Calculate collisions in workspace
-			 */
-			if (check_collisions(x0_endpoint, y0_endpoint, x1_endpoint, y1_endpoint)) {
-				LOG_DBG("Recording collision at angles: (theta0: %d, theta1: %d)",
-					theta0, theta1);
-				cspace[theta1][theta0] = OCCUPIED;
+		for (int theta1 = 0; theta1 < CONFIG_PATHFIND_ARM_RANGE;
+		     theta1 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
+
+			int angle = theta1 + (theta0 - (CONFIG_PATHFIND_ARM_RANGE / 2));
+
+			/* Without reference counts, occupied cells need no further checks */
+			if ((!IS_ENABLED(CONFIG_PATHFIND_DYNAMIC_OBSTACLES) &&
+			     cspace_bit_test(cspace, CSPACE_CELL(theta0), CSPACE_CELL(theta1))) ||
+			    !(arm1_all || angle_in_span(angle, arm1_start, arm1_width))) {
 				continue;
 			}
 
-			/* Calculate if arm is in-bounds. Mark as occupied if not. */
-			double temp_x;
-			double temp_y;
-			ret = get_arm_endpoint(theta0, theta1, CONFIG_PATHFIND_ARM_LEN_MM,
-					       CONFIG_PATHFIND_ARM_RANGE,
-					       CONFIG_PATHFIND_ARM_ORIGIN_X_MM,
-					       CONFIG_PATHFIND_ARM_ORIGIN_Y_MM, &temp_x, &temp_y);
+			bool collision;
+
+			ret = check_arm1_collision(x0_endpoint, y0_endpoint, angle, idx, &collision);
 			if (ret) {
-				LOG_ERR("ERROR calculating arm endpoint (err: %d)", ret);
 				return ret;
 			}
 
-			int int_x = (int)ceil(temp_x);
-			int int_y = (int)ceil(temp_y);
-			if (int_x < 0 || int_x >= WORKSPACE_DIMENSION || int_y < 0 ||
-			    int_y >= WORKSPACE_DIMENSION) {
-				cspace[theta1][theta0] = OCCUPIED;
+			if (collision) {
+				LOG_DBG("Recording collision at angles: (theta0: %d, theta1: %d)",
+					theta0, theta1);
+				update_cspace_cell(theta0, theta1, add);
 			}
 		}
 	}
 
-	LOG_INF("Finished Generating Configuration Space");
-
 	return 0;
 }
 
-uint8_t (*get_wspace(void))[WORKSPACE_DIMENSION]
+/**
+ * @brief Marks or unmarks the cspace cells blocked by a single obstacle
+ *
+ * @param[in] idx Index of the obstacle to be marked
+ * @param[in] add True to mark the obstacle, False to remove a previously marked one
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int update_obstacle_in_cspace(int idx, bool add)
 {
-	return wspace;
+#if defined(CONFIG_PATHFIND_CSPACE_CLEARANCE)
+	clearance_stale = true;
+#endif
+
+	return update_obstacle_in_columns(idx, add, 0, CONFIG_PATHFIND_ARM_RANGE);
+}
+
+/**
+ * @brief Computes the workspace cells an obstacle's bounding rectangle covers
+ *
+ * @param[in] obstacle The obstacle to bound
+ * @param[out] bounds Cells covered by the obstacle
+ */
+static void get_obstacle_bounds(const struct obstacle *obstacle, struct obstacle_bounds *bounds)
+{
+	struct rectangle aabb;
+	map_real_t min_x;
+	map_real_t min_y;
+	map_real_t max_x;
+	map_real_t max_y;
+
+	get_obstacle_aabb(obstacle, &aabb);
+	get_rectangle_bounds(&aabb, &min_x, &min_y, &max_x, &max_y);
+
+	bounds->min_x = (int16_t)MAP_REAL_FLOOR(min_x);
+	bounds->min_y = (int16_t)MAP_REAL_FLOOR(min_y);
+	bounds->max_x = (int16_t)MAP_REAL_FLOOR(max_x);
+	bounds->max_y = (int16_t)MAP_REAL_FLOOR(max_y);
 }
 
-uint8_t (*get_cspace(void))[CSPACE_DIMENSION]
+/**
+ * @brief Returns the obstacle grid bucket holding a workspace coordinate
+ *
+ * @param[in] coord X or Y coordinate, clamped to the workspace
+ *
+ * @retval Bucket index along that axis
+ */
+static inline int get_grid_bucket(int coord)
 {
-	return cspace;
+	return CLAMP(coord, 0, WORKSPACE_DIMENSION - 1) / OBSTACLE_GRID_CELL_MM;
 }
 
-void cleanup_cspace(void)
+/**
+ * @brief Adds or removes an obstacle from every grid bucket its bounds overlap
+ *
+ * @param[in] idx Index of the obstacle
+ * @param[in] bounds Cells covered by the obstacle
+ * @param[in] add True to add the obstacle, False to remove it
+ */
+static void update_obstacle_in_grid(int idx, const struct obstacle_bounds *bounds, bool add)
 {
-	for (int i = 0; i < CSPACE_DIMENSION; i++) {
-		for (int j = 0; j < CSPACE_DIMENSION; j++) {
-			if (cspace[j][i] == START_POINT || cspace[j][i] == END_POINT || cspace[j][i] == PATH) {
-				cspace[j][i] = FREE;
+	for (int y = get_grid_bucket(bounds->min_y); y <= get_grid_bucket(bounds->max_y); y++) {
+		for (int x = get_grid_bucket(bounds->min_x); x <= get_grid_bucket(bounds->max_x);
+		     x++) {
+			if (add) {
+				obstacle_grid[y][x][idx / 32] |= BIT(idx % 32);
+			} else {
+				obstacle_grid[y][x][idx / 32] &= ~BIT(idx % 32);
 			}
 		}
 	}
 }
+
+/**
+ * @brief Stores an obstacle in a slot of the obstacle list
+ *
+ * @param[in] idx Slot to store the obstacle in
+ * @param[in] obstacle The obstacle to store
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if the shape of the obstacle isn't enabled
+ * @retval -EINVAL if the obstacle is a degenerate polygon or circle
+ */
+static int store_obstacle(int idx, const struct obstacle *obstacle)
+{
+	struct obstacle stored;
+
+	/* Zero the unused bytes, the cache key is computed over the whole list */
+	memset(&stored, 0, sizeof(stored));
+	stored.shape = obstacle->shape;
+
+	switch (obstacle->shape) {
+	case MAP_SHAPE_RECTANGLE:
+		stored.rectangle = obstacle->rectangle;
+		break;
+#if defined(CONFIG_PATHFIND_CONVEX_OBSTACLES)
+	case MAP_SHAPE_POLYGON:
+	case MAP_SHAPE_CIRCLE: {
+		int ret = store_convex_shape(&convex_obstacles, idx, obstacle);
+
+		if (ret) {
+			return ret;
+		}
+
+		if (obstacle->shape == MAP_SHAPE_CIRCLE) {
+			stored.circle = obstacle->circle;
+		} else {
+			stored.polygon.num_vertices = obstacle->polygon.num_vertices;
+			memcpy(stored.polygon.vertices, obstacle->polygon.vertices,
+			       obstacle->polygon.num_vertices * sizeof(struct vertex));
+		}
+		break;
+	}
+#endif
+	default:
+		return -ENOTSUP;
+	}
+
+#if defined(CONFIG_PATHFIND_CONVEX_OBSTACLES)
+	if (stored.shape == MAP_SHAPE_RECTANGLE) {
+		convex_mask[idx / 32] &= ~BIT(idx % 32);
+	} else {
+		convex_mask[idx / 32] |= BIT(idx % 32);
+	}
+#endif
+
+	obstacles[idx] = stored;
+
+	return 0;
+}
+
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES) || defined(CONFIG_PATHFIND_CSPACE_STATIC)
+/**
+ * @brief Checks if a stored obstacle matches another obstacle
+ *
+ * @param[in] stored Obstacle from the obstacle list
+ * @param[in] obstacle Obstacle to compare against
+ *
+ * @retval True if both have the same shape and geometry, False otherwise
+ */
+static bool obstacle_matches(const struct obstacle *stored, const struct obstacle *obstacle)
+{
+	if (stored->shape != obstacle->shape) {
+		return false;
+	}
+
+	switch (stored->shape) {
+	case MAP_SHAPE_POLYGON:
+		return stored->polygon.num_vertices == obstacle->polygon.num_vertices &&
+		       memcmp(stored->polygon.vertices, obstacle->polygon.vertices,
+			      stored->polygon.num_vertices * sizeof(struct vertex)) == 0;
+	case MAP_SHAPE_CIRCLE:
+		return memcmp(&stored->circle, &obstacle->circle, sizeof(struct circle)) == 0;
+	default:
+		return memcmp(&stored->rectangle, &obstacle->rectangle,
+			      sizeof(struct rectangle)) == 0;
+	}
+}
+#endif
+
+/**
+ * @brief Checks if an obstacle covers a workspace cell
+ *
+ * @param[in] idx Index of the obstacle
+ * @param[in] x X coordinate in workspace
+ * @param[in] y Y coordinate in workspace
+ *
+ * @retval True if covered, False otherwise
+ */
+static bool obstacle_covers_cell(int idx, int x, int y)
+{
+	if (x < obstacle_bounds[idx].min_x || x > obstacle_bounds[idx].max_x ||
+	    y < obstacle_bounds[idx].min_y || y > obstacle_bounds[idx].max_y) {
+		return false;
+	}
+
+#if defined(CONFIG_PATHFIND_CONVEX_OBSTACLES)
+	/* Rectangles fill their bounds, other shapes only part of them */
+	if (obstacles[idx].shape != MAP_SHAPE_RECTANGLE) {
+		return check_point_convex_collision(MAP_REAL_FROM_INT(x), MAP_REAL_FROM_INT(y),
+						    &convex_obstacles, idx);
+	}
+#endif
+
+	return true;
+}
+
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
+/**
+ * @brief Marks the obstacle in the workspace
+ *
+ * @param[in] idx Index of the obstacle to be marked
+ * @param[in] marker Marker to fill the obstacle with
+ */
+static void mark_obstacle_in_workspace(int idx, uint8_t marker)
+{
+	const struct obstacle_bounds *bounds = &obstacle_bounds[idx];
+	int last_x = MIN(bounds->max_x, WORKSPACE_DIMENSION - 1);
+	int last_y = MIN(bounds->max_y, WORKSPACE_DIMENSION - 1);
+
+	for (int y = MAX(bounds->min_y, 0); y <= last_y; y++) {
+		for (int x = MAX(bounds->min_x, 0); x <= last_x; x++) {
+			if (obstacle_covers_cell(idx, x, y)) {
+				wspace[y][x] = marker;
+			}
+		}
+	}
+}
+#endif
+
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES) || defined(CONFIG_PATHFIND_CSPACE_LAZY)
+/**
+ * @brief Collects the obstacles sharing a grid bucket with an area
+ *
+ * @param[in] area Cells to look up
+ * @param[out] candidates Bitmap of obstacles that may overlap the area
+ */
+static void get_grid_candidates(const struct obstacle_bounds *area,
+				uint32_t candidates[OBSTACLE_WORDS])
+{
+	memset(candidates, 0, OBSTACLE_WORDS * sizeof(uint32_t));
+
+	for (int y = get_grid_bucket(area->min_y); y <= get_grid_bucket(area->max_y); y++) {
+		for (int x = get_grid_bucket(area->min_x); x <= get_grid_bucket(area->max_x); x++) {
+			for (int w = 0; w < OBSTACLE_WORDS; w++) {
+				candidates[w] |= obstacle_grid[y][x][w];
+			}
+		}
+	}
+}
+#endif
+
+#if defined(CONFIG_PATHFIND_CSPACE_LAZY)
+/**
+ * @brief Checks a single configuration against the workspace bounds and every obstacle
+ *
+ * Gives the same answer as the full generation, but only looks at the obstacles
+ * sharing a grid bucket with the area the arm sweeps.
+ *
+ * @param[in] theta0 Angle of inclination for ARM0
+ * @param[in] theta1 Angle of inclination for ARM1
+ *
+ * @retval True if the configuration is occupied, False otherwise
+ */
+static bool evaluate_configuration(int theta0, int theta1)
+{
+	int angle = theta1 + (theta0 - (CONFIG_PATHFIND_ARM_RANGE / 2));
+	uint32_t candidates[OBSTACLE_WORDS];
+	map_real_t x0_delta;
+	map_real_t y0_delta;
+	map_real_t x1_delta;
+	map_real_t y1_delta;
+	int int_x;
+	int int_y;
+	int ret;
+
+	ret = get_arm_end_cell(theta0, theta1, &int_x, &int_y);
+	if (!ret) {
+		ret = get_segment_endpoint_lut(ARM_LEN, MAP_UTILS_DEG_TO_STEPS(theta0), &x0_delta,
+					       &y0_delta);
+	}
+	if (!ret) {
+		ret = get_segment_endpoint_lut(ARM_LEN, MAP_UTILS_DEG_TO_STEPS(angle), &x1_delta,
+					       &y1_delta);
+	}
+	if (ret) {
+		LOG_ERR("ERROR calculating arm endpoint (err: %d)", ret);
+		return true;
+	}
+
+	if (int_x < 0 || int_x >= WORKSPACE_DIMENSION || int_y < 0 ||
+	    int_y >= WORKSPACE_DIMENSION) {
+		return true;
+	}
+
+	struct segment arm0 = {.x1 = ARM_ORIGIN_X,
+			       .y1 = ARM_ORIGIN_Y,
+			       .x2 = ARM_ORIGIN_X + x0_delta,
+			       .y2 = ARM_ORIGIN_Y + y0_delta};
+	struct segment arm1 = {
+		.x1 = arm0.x2, .y1 = arm0.y2, .x2 = arm0.x2 + x1_delta, .y2 = arm0.y2 + y1_delta};
+
+	/* Area swept by both arms, grown by a millimetre so rounding never culls a collision */
+	int margin = ARM_MARGIN_MM + 1;
+	struct obstacle_bounds area = {
+		.min_x = MAP_REAL_FLOOR(MIN(MIN(arm0.x1, arm0.x2), arm1.x2)) - margin,
+		.min_y = MAP_REAL_FLOOR(MIN(MIN(arm0.y1, arm0.y2), arm1.y2)) - margin,
+		.max_x = MAP_REAL_CEIL(MAX(MAX(arm0.x1, arm0.x2), arm1.x2)) + margin,
+		.max_y = MAP_REAL_CEIL(MAX(MAX(arm0.y1, arm0.y2), arm1.y2)) + margin,
+	};
+
+	get_grid_candidates(&area, candidates);
+
+#if defined(CONFIG_PATHFIND_CONVEX_OBSTACLES)
+	/* Polygons and circles are checked together, each arm setting up its box once */
+	uint32_t convex_candidates[OBSTACLE_WORDS];
+
+	for (int w = 0; w < OBSTACLE_WORDS; w++) {
+		convex_candidates[w] = candidates[w] & convex_mask[w];
+		candidates[w] &= ~convex_mask[w];
+	}
+
+	if (check_oriented_box_convex_set(&arm0, MAP_REAL_FROM_INT(ARM_MARGIN_MM),
+					  &convex_obstacles, convex_candidates, OBSTACLE_WORDS) ||
+	    check_oriented_box_convex_set(&arm1, MAP_REAL_FROM_INT(ARM_MARGIN_MM),
+					  &convex_obstacles, convex_candidates, OBSTACLE_WORDS)) {
+		return true;
+	}
+#endif
+
+	for (int w = 0; w < OBSTACLE_WORDS; w++) {
+		for (uint32_t word = candidates[w]; word != 0; word &= word - 1) {
+			int i = (w * 32) + find_lsb_set(word) - 1;
+
+			if (check_obstacle_collision(&arm0, i) ||
+			    check_obstacle_collision(&arm1, i)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+#endif /* CONFIG_PATHFIND_CSPACE_LAZY */
+
+int add_obstacle(const struct obstacle *obstacle)
+{
+	int ret;
+
+	if (num_obstacles >= MAX_NUM_OBJ) {
+		return -1;
+	}
+
+	ret = store_obstacle(num_obstacles, obstacle);
+	if (ret) {
+		return ret;
+	}
+
+	get_obstacle_bounds(obstacle, &obstacle_bounds[num_obstacles]);
+	update_obstacle_in_grid(num_obstacles, &obstacle_bounds[num_obstacles], true);
+
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
+	mark_obstacle_in_workspace(num_obstacles, OCCUPIED);
+#endif
+
+	num_obstacles++;
+
+#if defined(CONFIG_PATHFIND_CSPACE_LAZY)
+	/* A new obstacle can only block configurations, so only free ones are forgotten */
+	for (int y = 0; y < CSPACE_DIMENSION; y++) {
+		for (int w = 0; w < CSPACE_ROW_WORDS; w++) {
+			cspace_known[y][w] &= cspace[y][w];
+		}
+	}
+
+	return 0;
+#endif
+
+	/* Once cspace exists, only the region this obstacle can affect is rechecked */
+	if (cspace_generated) {
+		return update_obstacle_in_cspace(num_obstacles - 1, true);
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES)
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
+/**
+ * @brief Checks if two obstacle bounds overlap
+ *
+ * @param[in] a First obstacle bounds
+ * @param[in] b Second obstacle bounds
+ *
+ * @retval True if the bounds share any cell, False otherwise
+ */
+static bool bounds_overlap(const struct obstacle_bounds *a, const struct obstacle_bounds *b)
+{
+	return a->min_x <= b->max_x && b->min_x <= a->max_x && a->min_y <= b->max_y &&
+	       b->min_y <= a->max_y;
+}
+#endif
+
+int remove_obstacle(const struct obstacle *obstacle)
+{
+	int ret;
+	int idx = -1;
+	struct obstacle_bounds removed;
+	uint32_t candidates[OBSTACLE_WORDS];
+
+	/* Only obstacles sharing a grid bucket with it can match */
+	get_obstacle_bounds(obstacle, &removed);
+	get_grid_candidates(&removed, candidates);
+
+	for (int w = 0; w < OBSTACLE_WORDS && idx < 0; w++) {
+		for (uint32_t word = candidates[w]; word != 0; word &= word - 1) {
+			int i = (w * 32) + find_lsb_set(word) - 1;
+
+			if (obstacle_matches(&obstacles[i], obstacle)) {
+				idx = i;
+				break;
+			}
+		}
+	}
+
+	if (idx < 0) {
+		return -ENOENT;
+	}
+
+	/* Release the cspace cells this obstacle held, using the stored copy */
+	if (cspace_generated) {
+		ret = update_obstacle_in_cspace(idx, false);
+		if (ret) {
+			return ret;
+		}
+	}
+
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
+	mark_obstacle_in_workspace(idx, FREE);
+#endif
+
+	/* The last obstacle takes over the freed slot, so renumber it in the grid too */
+	update_obstacle_in_grid(idx, &obstacle_bounds[idx], false);
+	num_obstacles--;
+	if (idx != num_obstacles) {
+		update_obstacle_in_grid(num_obstacles, &obstacle_bounds[num_obstacles], false);
+		update_obstacle_in_grid(idx, &obstacle_bounds[num_obstacles], true);
+
+		/* Already stored once, so this can't fail */
+		(void)store_obstacle(idx, &obstacles[num_obstacles]);
+		obstacle_bounds[idx] = obstacle_bounds[num_obstacles];
+	}
+
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
+	/* Redraw any neighbours that shared its footprint */
+	get_grid_candidates(&removed, candidates);
+	for (int w = 0; w < OBSTACLE_WORDS; w++) {
+		for (uint32_t word = candidates[w]; word != 0; word &= word - 1) {
+			int i = (w * 32) + find_lsb_set(word) - 1;
+
+			if (bounds_overlap(&obstacle_bounds[i], &removed)) {
+				mark_obstacle_in_workspace(i, OCCUPIED);
+			}
+		}
+	}
+#endif
+
+	return 0;
+}
+
+int move_obstacle(const struct obstacle *obstacle, const struct obstacle *destination)
+{
+	int ret;
+
+	ret = remove_obstacle(obstacle);
+	if (ret) {
+		return ret;
+	}
+
+	return add_obstacle(destination);
+}
+
+#endif /* CONFIG_PATHFIND_DYNAMIC_OBSTACLES */
+
+/**
+ * @brief Marks the configurations that place the arm end outside the workspace
+ *
+ * @param[in] first First theta0 column to mark
+ * @param[in] last Column one past the last theta0 column to mark
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int mark_out_of_bounds_in_columns(int first, int last)
+{
+	int ret;
+
+	for (int theta0 = ROUND_UP(first, CONFIG_PATHFIND_ARM_DEGREE_INC); theta0 < last;
+	     theta0 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
+		for (int theta1 = 0; theta1 < CONFIG_PATHFIND_ARM_RANGE;
+		     theta1 += CONFIG_PATHFIND_ARM_DEGREE_INC) {
+			int int_x;
+			int int_y;
+
+			ret = get_arm_end_cell(theta0, theta1, &int_x, &int_y);
+			if (ret) {
+				LOG_ERR("ERROR calculating arm endpoint (err: %d)", ret);
+				return ret;
+			}
+
+			if (int_x < 0 || int_x >= WORKSPACE_DIMENSION || int_y < 0 ||
+			    int_y >= WORKSPACE_DIMENSION) {
+				update_cspace_cell(theta0, theta1, true);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Generates a block of theta0 columns of the cspace
+ *
+ * Columns are independent of each other, so blocks may be generated concurrently
+ * as long as no two blocks share a word of a cspace row.
+ *
+ * @param[in] first First theta0 column to generate
+ * @param[in] last Column one past the last theta0 column to generate
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int generate_cspace_columns(int first, int last)
+{
+	int ret;
+
+	/* Configurations reaching outside the workspace hold a permanent reference */
+	ret = mark_out_of_bounds_in_columns(first, last);
+	if (ret) {
+		return ret;
+	}
+
+	/*
+	 * Broad phase: rather than checking every configuration against every obstacle,
+	 * each obstacle only visits the configurations whose arms can reach it.
+	 */
+	for (int i = 0; i < num_obstacles; i++) {
+		ret = update_obstacle_in_columns(i, true, first, last);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Number of blocks of 32 theta0 columns, one per word of a cspace row
+ */
+#define CSPACE_COLUMN_BLOCKS DIV_ROUND_UP(CSPACE_DIMENSION, 32)
+
+/**
+ * @brief Generates every column block assigned to one worker
+ *
+ * Blocks are dealt out round robin, so worker n takes blocks n, n + threads and so on.
+ *
+ * @param[in] worker Index of the worker, from 0 to CONFIG_PATHFIND_CSPACE_THREADS - 1
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int generate_cspace_blocks(int worker)
+{
+	int ret;
+
+	for (int block = worker; block < CSPACE_COLUMN_BLOCKS;
+	     block += CONFIG_PATHFIND_CSPACE_THREADS) {
+		ret = generate_cspace_columns(
+			CSPACE_ANGLE(block * 32),
+			MIN(CSPACE_ANGLE((block + 1) * 32), CONFIG_PATHFIND_ARM_RANGE));
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+#if CONFIG_PATHFIND_CSPACE_THREADS > 1
+/**
+ * @brief Number of helper threads, the calling thread acts as the remaining worker
+ */
+#define CSPACE_HELPERS (CONFIG_PATHFIND_CSPACE_THREADS - 1)
+
+K_THREAD_STACK_ARRAY_DEFINE(cspace_helper_stacks, CSPACE_HELPERS,
+			    CONFIG_PATHFIND_CSPACE_THREAD_STACK_SIZE);
+static struct k_thread cspace_helpers[CSPACE_HELPERS];
+
+/**
+ * @brief Result of each helper thread
+ */
+static int cspace_helper_ret[CSPACE_HELPERS];
+
+static void cspace_helper_fn(void *p1, void *p2, void *p3)
+{
+	int helper = (int)(intptr_t)p1;
+
+	cspace_helper_ret[helper] = generate_cspace_blocks(helper + 1);
+}
+
+/**
+ * @brief Generates the cspace with a pool of worker threads
+ *
+ * Helpers run at the priority of the caller, which takes the first share of blocks
+ * itself and then joins the helpers.
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int generate_cspace_parallel(void)
+{
+	int prio = k_thread_priority_get(k_current_get());
+	int ret;
+
+	for (int i = 0; i < CSPACE_HELPERS; i++) {
+		k_thread_create(&cspace_helpers[i], cspace_helper_stacks[i],
+				K_THREAD_STACK_SIZEOF(cspace_helper_stacks[i]), cspace_helper_fn,
+				(void *)(intptr_t)i, NULL, NULL, prio, 0, K_NO_WAIT);
+		k_thread_name_set(&cspace_helpers[i], "cspace_helper");
+	}
+
+	ret = generate_cspace_blocks(0);
+
+	for (int i = 0; i < CSPACE_HELPERS; i++) {
+		k_thread_join(&cspace_helpers[i], K_FOREVER);
+
+		if (!ret && cspace_helper_ret[i]) {
+			ret = cspace_helper_ret[i];
+		}
+	}
+
+	return ret;
+}
+#endif /* CONFIG_PATHFIND_CSPACE_THREADS > 1 */
+
+#if defined(CONFIG_PATHFIND_CSPACE_STATIC)
+/**
+ * @brief Loads the cspace generated at build time for the static obstacles
+ *
+ * Obstacles known beyond the static table are applied on top of it.
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the known obstacles don't start with the static table
+ * @retval Other negative errno if applying the remaining obstacles failed
+ */
+static int load_static_cspace(void)
+{
+	int num_static = ARRAY_SIZE(static_obstacles);
+	int ret;
+
+	if (num_obstacles < num_static) {
+		return -ENOENT;
+	}
+
+	for (int i = 0; i < num_static; i++) {
+		if (!obstacle_matches(&obstacles[i], &static_obstacles[i])) {
+			return -ENOENT;
+		}
+	}
+
+	memcpy(cspace, static_cspace, sizeof(cspace));
+
+	for (int i = num_static; i < num_obstacles; i++) {
+		ret = update_obstacle_in_cspace(i, true);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	LOG_INF("Loaded static Configuration Space (%d obstacles added on top)",
+		num_obstacles - num_static);
+
+	return 0;
+}
+#endif /* CONFIG_PATHFIND_CSPACE_STATIC */
+
+#if defined(CONFIG_PATHFIND_CSPACE_CACHE)
+/**
+ * @brief Settings subtree holding the cached cspace
+ */
+#define CSPACE_CACHE_SUBTREE "pathfind/cspace"
+
+/**
+ * @brief Rows of the cspace bitmap stored in each settings entry
+ *
+ * Keeps each entry well within a single flash sector of the storage partition.
+ */
+#define CSPACE_CACHE_CHUNK_ROWS 16
+
+/**
+ * @brief Number of settings entries holding the cspace bitmap
+ */
+#define CSPACE_CACHE_CHUNKS DIV_ROUND_UP(CSPACE_DIMENSION, CSPACE_CACHE_CHUNK_ROWS)
+
+/**
+ * @brief Revision of the cspace model, bump when generation changes its output
+ */
+#define CSPACE_CACHE_VERSION 1
+
+/**
+ * @brief State of a cspace cache load
+ */
+struct cspace_cache_load {
+	uint32_t key;                                       /**< Key of the wanted cspace */
+	bool key_matched;                                   /**< Stored key is the wanted one */
+	uint32_t chunks[DIV_ROUND_UP(CSPACE_CACHE_CHUNKS, 32)]; /**< Chunks read so far */
+};
+
+/**
+ * @brief Computes the cache key of the cspace the current obstacles would generate
+ *
+ * Covers every option that changes the generated cspace, so a stale cache is never
+ * loaded after reconfiguring the arm.
+ *
+ * @retval CRC-32 of the arm geometry and obstacle table
+ */
+static uint32_t get_cspace_cache_key(void)
+{
+	static const int32_t geometry[] = {
+		CSPACE_CACHE_VERSION,
+		CONFIG_PATHFIND_WORKSPACE_SQMM,
+		CONFIG_PATHFIND_ARM_LEN_MM,
+		CONFIG_PATHFIND_ARM_WIDTH_MM,
+		CONFIG_PATHFIND_REQUIRED_CLEARANCE_MM,
+		CONFIG_PATHFIND_ARM_RANGE,
+		CONFIG_PATHFIND_ARM_DEGREE_INC,
+		CONFIG_PATHFIND_ARM_ORIGIN_X_MM,
+		CONFIG_PATHFIND_ARM_ORIGIN_Y_MM,
+		CONFIG_MAP_UTILS_TRIG_STEPS_PER_DEG,
+		IS_ENABLED(CONFIG_PATHFIND_CSPACE_ANALYTIC),
+		IS_ENABLED(CONFIG_MAP_UTILS_NUMERIC_FIXED),
+		sizeof(map_real_t),
+	};
+	uint32_t key;
+
+	key = crc32_ieee((const uint8_t *)geometry, sizeof(geometry));
+	key = crc32_ieee_update(key, (const uint8_t *)&num_obstacles, sizeof(num_obstacles));
+
+	return crc32_ieee_update(key, (const uint8_t *)obstacles,
+				 num_obstacles * sizeof(obstacles[0]));
+}
+
+/**
+ * @brief Size in bytes of one chunk of the cspace bitmap
+ *
+ * @param[in] chunk Index of the chunk
+ *
+ * @retval Size of the chunk, the last one may hold fewer rows
+ */
+static size_t get_cspace_cache_chunk_size(int chunk)
+{
+	int rows = MIN(CSPACE_CACHE_CHUNK_ROWS,
+		       CSPACE_DIMENSION - (chunk * CSPACE_CACHE_CHUNK_ROWS));
+
+	return rows * sizeof(cspace[0]);
+}
+
+/**
+ * @brief Reads one entry of the cached cspace
+ *
+ * Chunks are read straight into cspace, which is only trusted once the key
+ * matches and every chunk has been read.
+ */
+static int cspace_cache_load_cb(const char *name, size_t len, settings_read_cb read_cb,
+				void *cb_arg, void *param)
+{
+	struct cspace_cache_load *load = param;
+	const char *next;
+	char *end;
+
+	if (name == NULL) {
+		return 0;
+	}
+
+	if (settings_name_steq(name, "key", &next) && next == NULL) {
+		uint32_t stored;
+
+		if (len == sizeof(stored) &&
+		    read_cb(cb_arg, &stored, sizeof(stored)) == (ssize_t)sizeof(stored)) {
+			load->key_matched = (stored == load->key);
+		}
+		return 0;
+	}
+
+	unsigned long chunk = strtoul(name, &end, 10);
+
+	if (end == name || *end != '\0' || chunk >= CSPACE_CACHE_CHUNKS ||
+	    len != get_cspace_cache_chunk_size(chunk)) {
+		LOG_WRN("Ignoring cached cspace entry %s", name);
+		return 0;
+	}
+
+	if (read_cb(cb_arg, cspace[chunk * CSPACE_CACHE_CHUNK_ROWS], len) == (ssize_t)len) {
+		load->chunks[chunk / 32] |= BIT(chunk % 32);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Loads the cspace from the cache
+ *
+ * @param[in] key Cache key of the wanted cspace
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if no matching cspace is cached
+ * @retval Other negative errno if settings could not be read
+ */
+static int load_cspace_cache(uint32_t key)
+{
+	struct cspace_cache_load load = {.key = key};
+	int ret;
+
+	ret = settings_subsys_init();
+	if (ret) {
+		return ret;
+	}
+
+	ret = settings_load_subtree_direct(CSPACE_CACHE_SUBTREE, cspace_cache_load_cb, &load);
+	if (ret) {
+		return ret;
+	}
+
+	if (!load.key_matched) {
+		return -ENOENT;
+	}
+
+	for (int i = 0; i < CSPACE_CACHE_CHUNKS; i++) {
+		if (!(load.chunks[i / 32] & BIT(i % 32))) {
+			return -ENOENT;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Stores the cspace in the cache
+ *
+ * The key is dropped before the bitmap is rewritten and only stored once every
+ * chunk is written, so an interrupted save is never loaded.
+ *
+ * @param[in] key Cache key of the generated cspace
+ *
+ * @retval 0 on success, non-zero otherwise
+ */
+static int save_cspace_cache(uint32_t key)
+{
+	char name[sizeof(CSPACE_CACHE_SUBTREE) + 8];
+	int ret;
+
+	ret = settings_delete(CSPACE_CACHE_SUBTREE "/key");
+	if (ret) {
+		return ret;
+	}
+
+	for (int i = 0; i < CSPACE_CACHE_CHUNKS; i++) {
+		snprintf(name, sizeof(name), CSPACE_CACHE_SUBTREE "/%d", i);
+
+		ret = settings_save_one(name, cspace[i * CSPACE_CACHE_CHUNK_ROWS],
+					get_cspace_cache_chunk_size(i));
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return settings_save_one(CSPACE_CACHE_SUBTREE "/key", &key, sizeof(key));
+}
+#endif /* CONFIG_PATHFIND_CSPACE_CACHE */
+
+#if defined(CONFIG_PATHFIND_CSPACE_CLEARANCE)
+/**
+ * @brief Recomputes the clearance field from the cspace bitmap
+ *
+ * Two pass chamfer transform with unit cost to all eight neighbours, matching
+ * the steps the planner takes. The forward pass carries distances down and
+ * right, the backward pass up and left, which is exact for this metric.
+ * Configurations outside the cspace don't count as occupied.
+ */
+static void update_clearance(void)
+{
+	for (int y = 0; y < CSPACE_DIMENSION; y++) {
+		for (int x = 0; x < CSPACE_DIMENSION; x++) {
+			int d = CSPACE_CLEARANCE_MAX;
+
+			if (cspace_bit_test(cspace, x, y)) {
+				d = 0;
+			} else {
+				if (x > 0) {
+					d = MIN(d, cspace_clearance_field[y][x - 1] + 1);
+				}
+				if (y > 0) {
+					for (int nx = MAX(x - 1, 0);
+					     nx <= MIN(x + 1, CSPACE_DIMENSION - 1); nx++) {
+						d = MIN(d, cspace_clearance_field[y - 1][nx] + 1);
+					}
+				}
+			}
+
+			cspace_clearance_field[y][x] = d;
+		}
+	}
+
+	for (int y = CSPACE_DIMENSION - 1; y >= 0; y--) {
+		for (int x = CSPACE_DIMENSION - 1; x >= 0; x--) {
+			int d = cspace_clearance_field[y][x];
+
+			if (x < CSPACE_DIMENSION - 1) {
+				d = MIN(d, cspace_clearance_field[y][x + 1] + 1);
+			}
+			if (y < CSPACE_DIMENSION - 1) {
+				for (int nx = MAX(x - 1, 0); nx <= MIN(x + 1, CSPACE_DIMENSION - 1);
+				     nx++) {
+					d = MIN(d, cspace_clearance_field[y + 1][nx] + 1);
+				}
+			}
+
+			cspace_clearance_field[y][x] = d;
+		}
+	}
+
+	clearance_stale = false;
+}
+#endif /* CONFIG_PATHFIND_CSPACE_CLEARANCE */
+
+int generate_configuration_space()
+{
+	int ret;
+
+	ret = kinematics_init();
+	if (ret) {
+		return ret;
+	}
+
+#if defined(CONFIG_PATHFIND_CSPACE_CLEARANCE)
+	clearance_stale = true;
+#endif
+
+#if defined(CONFIG_PATHFIND_CSPACE_LAZY)
+	/* Configurations are evaluated when first queried, so just forget all of them */
+	memset(cspace, 0, sizeof(cspace));
+	memset(cspace_known, 0, sizeof(cspace_known));
+	cspace_generated = true;
+
+	LOG_INF("Configuration Space will be evaluated on demand");
+
+	return 0;
+#endif
+
+#if defined(CONFIG_PATHFIND_CSPACE_STATIC)
+	ret = load_static_cspace();
+	if (ret == 0) {
+		cspace_generated = true;
+		return 0;
+	} else if (ret != -ENOENT) {
+		return ret;
+	}
+
+	LOG_WRN("Obstacles don't match the static table");
+#endif
+
+#if defined(CONFIG_PATHFIND_CSPACE_CACHE)
+	uint32_t key = get_cspace_cache_key();
+
+	ret = load_cspace_cache(key);
+	if (ret == 0) {
+		LOG_INF("Loaded Configuration Space from cache (key: 0x%08x)", key);
+		cspace_generated = true;
+		return 0;
+	}
+
+	LOG_INF("No cached Configuration Space (err: %d)", ret);
+#endif
+
+	LOG_INF("Generating Configuration Space!!!");
+
+	memset(cspace, 0, sizeof(cspace));
+#if defined(CONFIG_PATHFIND_DYNAMIC_OBSTACLES)
+	memset(cspace_refs, 0, sizeof(cspace_refs));
+#endif
+
+#if CONFIG_PATHFIND_CSPACE_THREADS > 1
+	ret = generate_cspace_parallel();
+#else
+	ret = generate_cspace_blocks(0);
+#endif
+	if (ret) {
+		return ret;
+	}
+
+	cspace_generated = true;
+
+	LOG_INF("Finished Generating Configuration Space");
+
+#if defined(CONFIG_PATHFIND_CSPACE_CACHE)
+	/* A failed save only costs the next boot a regeneration */
+	ret = save_cspace_cache(key);
+	if (ret) {
+		LOG_WRN("Couldn't cache Configuration Space (err: %d)", ret);
+	}
+#endif
+
+	return 0;
+}
+
+bool workspace_is_occupied(int x, int y)
+{
+	const uint32_t *bucket = obstacle_grid[get_grid_bucket(y)][get_grid_bucket(x)];
+
+	/* Only obstacles overlapping this bucket can cover the cell */
+	for (int w = 0; w < OBSTACLE_WORDS; w++) {
+		for (uint32_t word = bucket[w]; word != 0; word &= word - 1) {
+			if (obstacle_covers_cell((w * 32) + find_lsb_set(word) - 1, x, y)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+#if defined(CONFIG_PATHFIND_WORKSPACE_RASTER)
+uint8_t (*get_wspace(void))[WORKSPACE_DIMENSION]
+{
+	return wspace;
+}
+#endif
+
+const uint32_t (*get_cspace(void))[CSPACE_ROW_WORDS]
+{
+	return (const uint32_t (*)[CSPACE_ROW_WORDS])cspace;
+}
+
+bool cspace_is_occupied(int theta0, int theta1)
+{
+	int x = CSPACE_CELL(theta0);
+	int y = CSPACE_CELL(theta1);
+
+#if defined(CONFIG_PATHFIND_CSPACE_LAZY)
+	if (!cspace_bit_test(cspace_known, x, y)) {
+		cspace_bit_set(cspace_known, x, y);
+		if (evaluate_configuration(CSPACE_ANGLE(x), CSPACE_ANGLE(y))) {
+			cspace_bit_set(cspace, x, y);
+		}
+	}
+#endif
+
+	return cspace_bit_test(cspace, x, y);
+}
+
+#if defined(CONFIG_PATHFIND_CSPACE_CLEARANCE)
+const uint8_t (*get_cspace_clearance(void))[CSPACE_DIMENSION]
+{
+	if (clearance_stale) {
+		update_clearance();
+	}
+
+	return (const uint8_t (*)[CSPACE_DIMENSION])cspace_clearance_field;
+}
+
+uint8_t cspace_clearance(int theta0, int theta1)
+{
+	return get_cspace_clearance()[CSPACE_CELL(theta1)][CSPACE_CELL(theta0)];
+}
+#endif
+
+/**
+ * @brief Finds the scratch slot of a cell
+ *
+ * Markers are never removed within a query, so the live markers sharing a hash
+ * always form an unbroken run of slots.
+ *
+ * @param[in] space Space from enum scratch_space
+ * @param[in] x theta0 in cspace, X coordinate in wspace
+ * @param[in] y theta1 in cspace, Y coordinate in wspace
+ *
+ * @retval Slot holding the marker of the cell if it has one, otherwise a free slot
+ */
+static struct scratch_marker *find_scratch_slot(uint8_t space, int x, int y)
+{
+	uint32_t hash = ((uint32_t)x * 2654435761U) ^ ((uint32_t)y * 2246822519U) ^
+			((uint32_t)space * 3266489917U);
+	uint32_t slot = hash >> (32 - SCRATCH_SLOT_BITS);
+
+	while (scratch[slot].epoch == scratch_epoch) {
+		if (scratch[slot].x == x && scratch[slot].y == y && scratch[slot].space == space) {
+			break;
+		}
+		slot = (slot + 1) & (SCRATCH_SLOTS - 1);
+	}
+
+	return &scratch[slot];
+}
+
+/**
+ * @brief Places a marker for the current query
+ *
+ * @param[in] space Space from enum scratch_space
+ * @param[in] x theta0 in cspace, X coordinate in wspace
+ * @param[in] y theta1 in cspace, Y coordinate in wspace
+ * @param[in] marker Marker to place
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the query already holds CSPACE_MAX_MARKERS markers in this space
+ */
+static int set_scratch_marker(uint8_t space, int x, int y, uint8_t marker)
+{
+	struct scratch_marker *slot = find_scratch_slot(space, x, y);
+
+	if (slot->epoch != scratch_epoch) {
+		if (num_scratch_markers[space] >= CSPACE_MAX_MARKERS) {
+			return -ENOMEM;
+		}
+
+		*slot = (struct scratch_marker){
+			.epoch = scratch_epoch, .x = x, .y = y, .space = space};
+		num_scratch_markers[space]++;
+	}
+
+	slot->marker = marker;
+
+	return 0;
+}
+
+uint8_t get_cspace_marker(int theta0, int theta1)
+{
+	struct scratch_marker *slot = find_scratch_slot(SCRATCH_CSPACE, theta0, theta1);
+
+	if (slot->epoch == scratch_epoch) {
+		return slot->marker;
+	}
+
+	return cspace_is_occupied(theta0, theta1) ? OCCUPIED : FREE;
+}
+
+int set_cspace_marker(int theta0, int theta1, uint8_t marker)
+{
+	return set_scratch_marker(SCRATCH_CSPACE, theta0, theta1, marker);
+}
+
+uint8_t get_wspace_marker(int x, int y)
+{
+	struct scratch_marker *slot = find_scratch_slot(SCRATCH_WSPACE, x, y);
+
+	if (slot->epoch == scratch_epoch) {
+		return slot->marker;
+	}
+
+	return workspace_is_occupied(x, y) ? OCCUPIED : FREE;
+}
+
+int set_wspace_marker(int x, int y, uint8_t marker)
+{
+	return set_scratch_marker(SCRATCH_WSPACE, x, y, marker);
+}
+
+void cleanup_cspace(void)
+{
+	/* Every marker placed so far goes stale at once */
+	scratch_epoch++;
+	if (scratch_epoch == 0) {
+		memset(scratch, 0, sizeof(scratch));
+		scratch_epoch = 1;
+	}
+
+	memset(num_scratch_markers, 0, sizeof(num_scratch_markers));
+}
@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Firmware configuration for the host generator. Geometry and numeric options
+ * are taken as is, while features that need a kernel, or would make the
+ * generator depend on its own output, are turned off.
+ */
+
+#ifndef GEN_STATIC_CSPACE_HOST_CONFIG_H_
+#define GEN_STATIC_CSPACE_HOST_CONFIG_H_
+
+#include AUTOCONF_H
+
+#undef CONFIG_PATHFIND_CSPACE_THREADS
+#define CONFIG_PATHFIND_CSPACE_THREADS 1
+
+#undef CONFIG_PATHFIND_CSPACE_CACHE
+#undef CONFIG_PATHFIND_CSPACE_STATIC
+#undef CONFIG_PATHFIND_DYNAMIC_OBSTACLES
+
+#endif /* GEN_STATIC_CSPACE_HOST_CONFIG_H_ */
@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host stand-in for the parts of the Zephyr kernel API used by map_utils and
+ * spaces.c, so they can run unmodified in the build-time cspace generator.
+ */
+
+#ifndef GEN_STATIC_CSPACE_KERNEL_H_
+#define GEN_STATIC_CSPACE_KERNEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+#define MIN(a, b)         (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)         (((a) > (b)) ? (a) : (b))
+#define CLAMP(val, low, high) \
+	(((val) <= (low)) ? (low) : MIN(val, high))
+#define ROUND_UP(x, align)  ((((x) + ((align) - 1)) / (align)) * (align))
+#define DIV_ROUND_UP(n, d)  (((n) + (d) - 1) / (d))
+#define BIT(n)              (1UL << (n))
+#define BUILD_ASSERT(expr, ...) _Static_assert(expr, "" __VA_ARGS__)
+
+/* Same trick as Zephyr, evaluates to 1 only for macros defined as 1 */
+#define IS_ENABLED(config)            Z_IS_ENABLED1(config)
+#define Z_IS_ENABLED1(config)         Z_IS_ENABLED2(_XXXX##config)
+#define _XXXX1                        _YYYY,
+#define Z_IS_ENABLED2(one_or_two_args) Z_IS_ENABLED3(one_or_two_args 1, 0)
+#define Z_IS_ENABLED3(ignore_this, val, ...) val
+
+static inline unsigned int find_lsb_set(uint32_t op)
+{
+	return (op == 0) ? 0 : (unsigned int)__builtin_ctz(op) + 1;
+}
+
+#endif /* GEN_STATIC_CSPACE_KERNEL_H_ */
@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host stand-in for Zephyr logging, warnings and errors go to stderr.
+ */
+
+#ifndef GEN_STATIC_CSPACE_LOG_H_
+#define GEN_STATIC_CSPACE_LOG_H_
+
+#include <stdio.h>
+
+#define LOG_MODULE_REGISTER(...)
+
+#define LOG_ERR(fmt, ...) fprintf(stderr, "error: " fmt "\n", ##__VA_ARGS__)
+#define LOG_WRN(fmt, ...) fprintf(stderr, "warning: " fmt "\n", ##__VA_ARGS__)
+#define LOG_INF(fmt, ...) do { } while (0)
+#define LOG_DBG(fmt, ...) do { } while (0)
+
+#endif /* GEN_STATIC_CSPACE_LOG_H_ */
@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Build-time cspace generator
+ *
+ * Runs the firmware's own spaces.c on the host for the static obstacle table
+ * and writes the resulting occupancy bitmap as a const array the firmware links
+ * into flash.
+ */
+
+#include <stdio.h>
+#include <zephyr/kernel.h>
+
+#include <lib/pathfind/spaces.h>
+
+#include PATHFIND_STATIC_OBSTACLES_H
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <output header>\n", argv[0]);
+		return 1;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(static_obstacles); i++) {
+		ret = add_obstacle(&static_obstacles[i]);
+		if (ret) {
+			fprintf(stderr, "error: couldn't add static obstacle %zu (err: %d)\n", i, ret);
+			return 1;
+		}
+	}
+
+	ret = generate_configuration_space();
+	if (ret) {
+		fprintf(stderr, "error: couldn't generate configuration space (err: %d)\n", ret);
+		return 1;
+	}
+
+	const uint32_t(*cspace)[CSPACE_ROW_WORDS] = get_cspace();
+	FILE *f = fopen(argv[1], "w");
+
+	if (f == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	fprintf(f, "/*\n"
+		   " * Generated by scripts/gen_static_cspace, do not edit.\n"
+		   " *\n"
+		   " * Occupancy bitmap for the %zu static obstacles in\n"
+		   " * %s\n"
+		   " */\n\n",
+		ARRAY_SIZE(static_obstacles), PATHFIND_STATIC_OBSTACLES_H);
+	fprintf(f, "#define STATIC_CSPACE_DIMENSION %d\n", CSPACE_DIMENSION);
+	fprintf(f, "#define STATIC_CSPACE_ROW_WORDS %d\n\n", CSPACE_ROW_WORDS);
+	fprintf(f, "static const uint32_t static_cspace[STATIC_CSPACE_DIMENSION]"
+		   "[STATIC_CSPACE_ROW_WORDS] = {\n");
+
+	for (int row = 0; row < CSPACE_DIMENSION; row++) {
+		fprintf(f, "\t{");
+		for (int word = 0; word < CSPACE_ROW_WORDS; word++) {
+			fprintf(f, "%s0x%08xU", (word == 0) ? "" : ", ", cspace[row][word]);
+		}
+		fprintf(f, "},\n");
+	}
+
+	fprintf(f, "};\n");
+
+	if (fclose(f)) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+# SPDX-License-Identifier: Apache-2.0
+
+'''gen_trig_table.py
+
+Generate the sine/cosine lookup tables used by the map_utils kinematics.
+
+The tables cover a full turn at a fixed number of steps per degree, so any
+angle that is a multiple of the step can be looked up instead of computed.
+Entries are wrapped in MAP_REAL() so the header follows the numeric backend
+selected for map_utils, and must be included after <lib/map_utils.h>.'''
+
+import argparse
+import math
+
+
+def format_table(name, values):
+    lines = [f"static const map_real_t {name}[TRIG_TABLE_SIZE] = {{"]
+    for i in range(0, len(values), 4):
+        row = ", ".join(f"MAP_REAL({v!r})" for v in values[i:i + 4])
+        lines.append(f"\t{row},")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--steps-per-deg', type=int, required=True,
+                        help='number of table entries per degree')
+    parser.add_argument('--output', required=True, help='header file to write')
+    args = parser.parse_args()
+
+    size = 360 * args.steps_per_deg
+
+    # Same expression as get_segment_endpoint_trig() so results match exactly
+    radians = [(i / args.steps_per_deg) * math.pi / 180.0 for i in range(size)]
+    sines = [math.sin(r) for r in radians]
+    cosines = [math.cos(r) for r in radians]
+
+    with open(args.output, 'w') as f:
+        f.write("/*\n")
+        f.write(" * SPDX-License-Identifier: Apache-2.0\n")
+        f.write(" *\n")
+        f.write(" * Generated by scripts/gen_trig_table.py, do not edit.\n")
+        f.write(" */\n\n")
+        f.write("#ifndef TRIG_TABLE_H_\n")
+        f.write("#define TRIG_TABLE_H_\n\n")
+        f.write(f"#define TRIG_TABLE_STEPS_PER_DEG {args.steps_per_deg}\n\n")
+        f.write(f"#define TRIG_TABLE_SIZE {size}\n\n")
+        f.write(format_table("trig_table_sin", sines))
+        f.write("\n\n")
+        f.write(format_table("trig_table_cos", cosines))
+        f.write("\n\n#endif /* TRIG_TABLE_H_ */\n")
+
+
+if __name__ == '__main__':
+    main()
@@ -9,12 +9,21 @@
 
 #define EPSILON 0.001
 
+/* Table-driven kinematics carry the rounding of the selected numeric backend */
+#define KINEMATICS_EPSILON 0.01
+
+/* Arm used to compare the numeric backends against double precision */
+#define ARM_LEN      81
+#define ARM_ORIGIN_X 193
+#define ARM_ORIGIN_Y 29
+#define ARM_MARGIN   21
+
 static void set_segment(struct segment *seg, double x1, double y1, double x2, double y2)
 {
-        seg->x1 = x1;
-        seg->y1 = y1;
-        seg->x2 = x2;
-        seg->y2 = y2;
+        seg->x1 = MAP_REAL(x1);
+        seg->y1 = MAP_REAL(y1);
+        seg->x2 = MAP_REAL(x2);
+        seg->y2 = MAP_REAL(y2);
 }
 
 static bool float_equal(double a, double b)
@@ -22,61 +31,90 @@ static bool float_equal(double a, double b)
         return fabs(a - b) < EPSILON;
 }
 
+static bool real_equal(map_real_t a, double b, double epsilon)
+{
+        return fabs(MAP_REAL_TO_DOUBLE(a) - b) < epsilon;
+}
+
 static bool compare_segments(struct segment s1, struct segment s2)
 {
-        if (!float_equal(s1.x1, s2.x1)) {
+        if (!real_equal(s1.x1, MAP_REAL_TO_DOUBLE(s2.x1), EPSILON)) {
                 return false;
-        } else if(!float_equal(s1.y1, s2.y1)) {
+        } else if(!real_equal(s1.y1, MAP_REAL_TO_DOUBLE(s2.y1), EPSILON)) {
                 return false;
-        } else if(!float_equal(s1.x2, s2.x2)) {
+        } else if(!real_equal(s1.x2, MAP_REAL_TO_DOUBLE(s2.x2), EPSILON)) {
                 return false;
-        } else if(!float_equal(s1.y2, s2.y2)) {
+        } else if(!real_equal(s1.y2, MAP_REAL_TO_DOUBLE(s2.y2), EPSILON)) {
                 return false;
         }
 
         return true;
 }
 
+/* Double precision reference for a box of half width ARM_MARGIN around a segment */
+static bool ref_arm_collides(double x1, double y1, double x2, double y2, const double box[4])
+{
+        double len = hypot(x2 - x1, y2 - y1);
+        double ux = (x2 - x1) / len;
+        double uy = (y2 - y1) / len;
+        double cx = (box[0] + box[2]) / 2 - (x1 + x2) / 2;
+        double cy = (box[1] + box[3]) / 2 - (y1 + y2) / 2;
+        double hx = (box[2] - box[0]) / 2;
+        double hy = (box[3] - box[1]) / 2;
+
+        /* Separating axis test along x, y, the segment and its normal */
+        return fabs(cx) <= hx + fabs(ux) * len / 2 + fabs(uy) * ARM_MARGIN &&
+               fabs(cy) <= hy + fabs(uy) * len / 2 + fabs(ux) * ARM_MARGIN &&
+               fabs(cx * ux + cy * uy) <= len / 2 + hx * fabs(ux) + hy * fabs(uy) &&
+               fabs(cy * ux - cx * uy) <= ARM_MARGIN + hx * fabs(uy) + hy * fabs(ux);
+}
+
+/* Same check as ref_arm_collides() in the selected numeric backend */
+static bool arm_collides(struct segment seg, struct rectangle rect)
+{
+        return check_oriented_box_rectangle_collision(&seg, MAP_REAL(ARM_MARGIN), &rect);
+}
+
 ZTEST(map_utils, test_segment_translation)
 {
         struct segment start;
         struct segment end;
-        double mag;
+        map_real_t mag;
 
         /* Horizontal line shift */
         set_segment(&start, 0, 0, 4, 0);
         set_segment(&end, 0, 2, 4, 2);
-        mag = 2;
+        mag = MAP_REAL(2);
         zassert_equal(compare_segments(translate_segment(start, mag), end), true);
 
         /* Vertical line shift */
         set_segment(&start, 0, 0, 0, 4);
         set_segment(&end, -2, 0, -2, 4);
-        mag = 2;
+        mag = MAP_REAL(2);
         zassert_equal(compare_segments(translate_segment(start, mag), end), true);
 
         /* Diagonal line shift */
         set_segment(&start, 0, 0, 3, 3);
         set_segment(&end, -1.414, 1.414, 1.586, 4.414);
-        mag = 2;
+        mag = MAP_REAL(2);
         zassert_equal(compare_segments(translate_segment(start, mag), end), true);
 
         /* Negative shift */
         set_segment(&start, 0, 0, 4, 3);
         set_segment(&end, 1.2, -1.6, 5.2, 1.4);
-        mag = -2;
+        mag = MAP_REAL(-2);
         zassert_equal(compare_segments(translate_segment(start, mag), end), true);
 
         /* Very small shift */
         set_segment(&start, 1, 1, 4, 5);
         set_segment(&end, 0.9997, 1.0006, 3.9997, 5.0006);
-        mag = 0.001;
+        mag = MAP_REAL(0.001);
         zassert_equal(compare_segments(translate_segment(start, mag), end), true);
 
         /* Very large shift */
         set_segment(&start, 0, 0, 1, 1);
         set_segment(&end, -707.107, 707.107, -706.107, 708.107);
-        mag = 1000;
+        mag = MAP_REAL(1000);
         zassert_equal(compare_segments(translate_segment(start, mag), end), true);
 }
 
@@ -154,34 +192,129 @@ ZTEST(map_utils, test_segment_end_trig)
         zassert_equal(float_equal(y, 5 * sin(359 * M_PI / 180)), true);
 }
 
-ZTEST(map_utils, test_rectangle_intersect)
+ZTEST(map_utils, test_segment_end_lut)
+{
+        map_real_t x;
+        map_real_t y;
+        double ref_x;
+        double ref_y;
+        int ret;
+
+        ret = get_segment_endpoint_lut(MAP_REAL(5), 0, NULL, &y);
+        zassert_equal(ret, -EINVAL);
+
+        ret = get_segment_endpoint_lut(MAP_REAL(5), 0, &x, NULL);
+        zassert_equal(ret, -EINVAL);
+
+        /* Table matches direct computation across and beyond a full turn */
+        for (int deg = -450; deg <= 450; deg += 15) {
+                ret = get_segment_endpoint_lut(MAP_REAL(ARM_LEN), MAP_UTILS_DEG_TO_STEPS(deg), &x,
+                                               &y);
+                zassert_equal(ret, 0);
+
+                get_segment_endpoint_trig(ARM_LEN, deg, &ref_x, &ref_y);
+                zassert_equal(real_equal(x, ref_x, KINEMATICS_EPSILON), true);
+                zassert_equal(real_equal(y, ref_y, KINEMATICS_EPSILON), true);
+        }
+
+        /* Arm endpoint matches direct computation */
+        for (int theta0 = 0; theta0 < 180; theta0 += 20) {
+                for (int theta1 = 0; theta1 < 180; theta1 += 20) {
+                        ret = get_arm_endpoint_lut(MAP_UTILS_DEG_TO_STEPS(theta0),
+                                                   MAP_UTILS_DEG_TO_STEPS(theta1),
+                                                   MAP_REAL(ARM_LEN), MAP_REAL(ARM_ORIGIN_X),
+                                                   MAP_REAL(ARM_ORIGIN_Y), &x, &y);
+                        zassert_equal(ret, 0);
+
+                        get_arm_endpoint(theta0, theta1, ARM_LEN, 180, ARM_ORIGIN_X,
+                                         ARM_ORIGIN_Y, &ref_x, &ref_y);
+                        zassert_equal(real_equal(x, ref_x, KINEMATICS_EPSILON), true);
+                        zassert_equal(real_equal(y, ref_y, KINEMATICS_EPSILON), true);
+                }
+        }
+}
+
+/**
+ * @brief Solutions collected by collect_arm_angles()
+ */
+struct arm_angles_list {
+        struct arm_angles *solutions;
+        int num_solutions;
+        int max_solutions;
+};
+
+static int collect_arm_angles(struct arm_angles angles, void *user_data)
+{
+        struct arm_angles_list *list = user_data;
+
+        if (list->num_solutions == list->max_solutions) {
+                return -ENOMEM;
+        }
+
+        list->solutions[list->num_solutions++] = angles;
+
+        return 0;
+}
+
+ZTEST(map_utils, test_arm_inverse_lut)
 {
-        struct rectangle rect = {
-                .bottom = {
-                        .x1 = 0,
-                        .y1 = 0,
-                        .x2 = 4,
-                        .y2 = 0
-                },
-                .top = {
-                        .x1 = 0,
-                        .y1 = 4,
-                        .x2 = 4,
-                        .y2 = 4
-                },
-                .left = {
-                        .x1 = 0,
-                        .y1 = 0,
-                        .x2 = 0,
-                        .y2 = 4
-                },
-                .right = {
-                        .x1 = 4,
-                        .y1 = 0,
-                        .x2 = 4,
-                        .y2 = 4
+        static struct arm_angles solutions[256];
+        struct arm_angles_list list;
+        /* Both elbows, full stretch, and too close or too far to reach */
+        int targets[][3] = {{260, 140, 0}, {260, 140, 1}, {120, 150, 3}, {193, 191, 2},
+                            {355, 29, 2}, {193, 110, 2}, {400, 29, 3}};
+
+        for (size_t i = 0; i < ARRAY_SIZE(targets); i++) {
+                int x = targets[i][0];
+                int y = targets[i][1];
+                int tolerance = targets[i][2];
+                int num_solutions;
+                int idx = 0;
+
+                list = (struct arm_angles_list){solutions, 0, ARRAY_SIZE(solutions)};
+                num_solutions = get_arm_inverse_lut(x, y, tolerance, MAP_REAL(ARM_LEN),
+                                                    MAP_REAL(ARM_ORIGIN_X), MAP_REAL(ARM_ORIGIN_Y),
+                                                    180, 1, collect_arm_angles, &list);
+
+                zassert_true(num_solutions >= 0);
+                zassert_equal(list.num_solutions, num_solutions);
+
+                /* Same configurations, in the same order, as a scan of every one */
+                for (int theta0 = 0; theta0 < 180; theta0++) {
+                        for (int theta1 = 0; theta1 < 180; theta1++) {
+                                map_real_t end_x;
+                                map_real_t end_y;
+
+                                get_arm_endpoint_lut(MAP_UTILS_DEG_TO_STEPS(theta0),
+                                                     MAP_UTILS_DEG_TO_STEPS(theta1),
+                                                     MAP_REAL(ARM_LEN), MAP_REAL(ARM_ORIGIN_X),
+                                                     MAP_REAL(ARM_ORIGIN_Y), &end_x, &end_y);
+                                if (abs(MAP_REAL_CEIL(end_x) - x) > tolerance ||
+                                    abs(MAP_REAL_CEIL(end_y) - y) > tolerance) {
+                                        continue;
+                                }
+
+                                zassert_true(idx < num_solutions);
+                                zassert_equal(solutions[idx].theta0, theta0);
+                                zassert_equal(solutions[idx].theta1, theta1);
+                                idx++;
+                        }
                 }
-        };
+                zassert_equal(idx, num_solutions);
+        }
+
+        /* The callback stops the lookup */
+        list = (struct arm_angles_list){solutions, 0, 1};
+        zassert_equal(get_arm_inverse_lut(120, 150, 3, MAP_REAL(ARM_LEN), MAP_REAL(ARM_ORIGIN_X),
+                                          MAP_REAL(ARM_ORIGIN_Y), 180, 1, collect_arm_angles,
+                                          &list),
+                      -ENOMEM);
+        zassert_equal(list.num_solutions, 1);
+}
+
+ZTEST(map_utils, test_rectangle_intersect)
+{
+        struct rectangle rect = MAP_RECTANGLE(0, 0, 4, 4);
         struct segment s;
 
         /* Segment exactly aligns with edge */
@@ -201,6 +334,315 @@ ZTEST(map_utils, test_rectangle_intersect)
         zassert_equal(check_segment_rectangle_collisions(s, rect), true);
 }
 
+ZTEST(map_utils, test_segment_aabb)
+{
+        struct rectangle rect = MAP_RECTANGLE(0, 0, 4, 4);
+        struct segment s;
+
+        /* Segment wholly inside, which edge crossing alone misses */
+        set_segment(&s, 1, 1, 3, 2);
+        zassert_equal(check_segment_rectangle_collisions(s, rect), false);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), true);
+
+        /* One end inside */
+        set_segment(&s, 2, 2, 10, 3);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), true);
+
+        /* Passing through both sides */
+        set_segment(&s, -1, 2, 5, 2);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), true);
+
+        /* Lying along an edge, and touching a corner */
+        set_segment(&s, -2, 4, 6, 4);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), true);
+        set_segment(&s, 4, 4, 8, 8);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), true);
+
+        /* Parallel and outside */
+        set_segment(&s, -2, 5, 6, 5);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), false);
+
+        /* Diagonal passing just beyond a corner */
+        set_segment(&s, 3, 6, 6, 3);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), false);
+
+        /* Heading towards the rectangle but stopping short */
+        set_segment(&s, -5, 2, -0.5, 2);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), false);
+
+        /* Points */
+        set_segment(&s, 2, 2, 2, 2);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), true);
+        set_segment(&s, 5, 2, 5, 2);
+        zassert_equal(check_segment_aabb_collision(&s, &rect), false);
+}
+
+ZTEST(map_utils, test_oriented_box_intersect)
+{
+        struct rectangle rect = MAP_RECTANGLE(0, 0, 4, 4);
+        struct rectangle thin = MAP_RECTANGLE(20, -1, 40, 1);
+        struct segment s;
+
+        /* Centre line crosses the rectangle */
+        set_segment(&s, -1, 2, 5, 2);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(1), &rect), true);
+
+        /* Box entirely inside the rectangle */
+        set_segment(&s, 1, 1, 3, 3);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(0.5), &rect), true);
+
+        /* Parallel to an edge, just within and just outside the half width */
+        set_segment(&s, -10, 6, 10, 6);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(2.1), &rect), true);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(1.9), &rect), false);
+
+        /* Ends are flat, so a wide box stopping short of the rectangle misses it */
+        set_segment(&s, -10, 2, -0.1, 2);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(10), &rect), false);
+        set_segment(&s, 7, 7, 20, 20);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(10), &rect), false);
+
+        /* Diagonal passing a corner */
+        set_segment(&s, 2, 8, 8, 2);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(1.5), &rect), true);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(1.3), &rect), false);
+
+        /* Thin obstacle between the offsets a five sample sweep of width 42 would test */
+        set_segment(&s, 0, 5, 60, 5);
+        zassert_equal(check_segment_rectangle_collisions(translate_segment(s, MAP_REAL(-1)),
+                                                         thin), false);
+        zassert_equal(check_segment_rectangle_collisions(translate_segment(s, MAP_REAL(-11)),
+                                                         thin), false);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(21), &thin), true);
+
+        /* Zero length segment only collides from inside */
+        set_segment(&s, 2, 2, 2, 2);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(1), &rect), true);
+        set_segment(&s, 5, 2, 5, 2);
+        zassert_equal(check_oriented_box_rectangle_collision(&s, MAP_REAL(1), &rect), false);
+}
+
+ZTEST(map_utils, test_convex_obstacles)
+{
+        static uint8_t num_vertices[3];
+        static map_real_t x[MAP_POLYGON_MAX_VERTICES * 3], y[MAP_POLYGON_MAX_VERTICES * 3];
+        static map_real_t normal_x[MAP_POLYGON_MAX_VERTICES * 3];
+        static map_real_t normal_y[MAP_POLYGON_MAX_VERTICES * 3];
+        static map_real_t radius[3];
+        struct convex_set set = {.stride = 3, .num_vertices = num_vertices, .x = x, .y = y,
+                                 .normal_x = normal_x, .normal_y = normal_y, .radius = radius};
+        /* Clockwise diamond, stored counter-clockwise */
+        struct obstacle diamond = MAP_OBSTACLE_POLYGON(MAP_VERTEX(10, 0), MAP_VERTEX(0, -10),
+                                                       MAP_VERTEX(-10, 0), MAP_VERTEX(0, 10));
+        struct obstacle triangle = MAP_OBSTACLE_POLYGON(MAP_VERTEX(40, 0), MAP_VERTEX(60, 0),
+                                                        MAP_VERTEX(40, 20));
+        struct obstacle circle = MAP_OBSTACLE_CIRCLE(0, 40, 5);
+        struct obstacle line = MAP_OBSTACLE_POLYGON(MAP_VERTEX(0, 0), MAP_VERTEX(5, 5),
+                                                    MAP_VERTEX(10, 10));
+        struct obstacle rect = MAP_OBSTACLE_RECTANGLE(0, 0, 1, 1);
+        uint32_t candidates = BIT(0) | BIT(2);
+        struct rectangle aabb;
+        map_real_t min_x, min_y, max_x, max_y;
+        struct segment s;
+
+        zassert_equal(store_convex_shape(&set, 0, &diamond), 0);
+        zassert_equal(store_convex_shape(&set, 1, &triangle), 0);
+        zassert_equal(store_convex_shape(&set, 2, &circle), 0);
+        zassert_equal(store_convex_shape(&set, 0, &line), -EINVAL);
+        zassert_equal(store_convex_shape(&set, 0, &rect), -EINVAL);
+        zassert_equal(store_convex_shape(&set, 0, &diamond), 0);
+
+        get_obstacle_aabb(&triangle, &aabb);
+        get_rectangle_bounds(&aabb, &min_x, &min_y, &max_x, &max_y);
+        zassert_true(real_equal(min_x, 40, EPSILON) && real_equal(max_x, 60, EPSILON));
+        get_obstacle_aabb(&circle, &aabb);
+        get_rectangle_bounds(&aabb, &min_x, &min_y, &max_x, &max_y);
+        zassert_true(real_equal(min_y, 35, EPSILON) && real_equal(max_y, 45, EPSILON));
+
+        /* Points inside, on the boundary and just outside */
+        zassert_true(check_point_convex_collision(MAP_REAL(0), MAP_REAL(0), &set, 0));
+        zassert_true(check_point_convex_collision(MAP_REAL(5), MAP_REAL(5), &set, 0));
+        zassert_false(check_point_convex_collision(MAP_REAL(5.5), MAP_REAL(5), &set, 0));
+        zassert_true(check_point_convex_collision(MAP_REAL(50), MAP_REAL(10), &set, 1));
+        zassert_false(check_point_convex_collision(MAP_REAL(50), MAP_REAL(10.5), &set, 1));
+        zassert_true(check_point_convex_collision(MAP_REAL(3), MAP_REAL(44), &set, 2));
+        zassert_false(check_point_convex_collision(MAP_REAL(4), MAP_REAL(44), &set, 2));
+
+        /* Box parallel to a diamond edge, 7.07 away */
+        set_segment(&s, 0, 20, 20, 0);
+        zassert_false(check_oriented_box_convex_collision(&s, MAP_REAL(6.5), &set, 0));
+        zassert_true(check_oriented_box_convex_collision(&s, MAP_REAL(7.5), &set, 0));
+
+        /* Box parallel to the hypotenuse of the triangle, 3.54 away */
+        set_segment(&s, 45, 20, 65, 0);
+        zassert_false(check_oriented_box_convex_collision(&s, MAP_REAL(3), &set, 1));
+        zassert_true(check_oriented_box_convex_collision(&s, MAP_REAL(4), &set, 1));
+
+        /* Box ending short of the circle, then reaching into it */
+        set_segment(&s, -20, 40, -8, 40);
+        zassert_false(check_oriented_box_convex_collision(&s, MAP_REAL(2), &set, 2));
+        set_segment(&s, -20, 40, -4, 40);
+        zassert_true(check_oriented_box_convex_collision(&s, MAP_REAL(2), &set, 2));
+        /* Box corner inside the circle bounds but outside the circle */
+        set_segment(&s, -20, 48, -4, 48);
+        zassert_false(check_oriented_box_convex_collision(&s, MAP_REAL(3.5), &set, 2));
+
+        /* Batch check only considers the selected shapes */
+        set_segment(&s, 45, 20, 65, 0);
+        zassert_false(check_oriented_box_convex_set(&s, MAP_REAL(4), &set, &candidates, 1));
+        candidates |= BIT(1);
+        zassert_true(check_oriented_box_convex_set(&s, MAP_REAL(4), &set, &candidates, 1));
+}
+
+ZTEST(map_utils, test_rectangle_span)
+{
+        struct rectangle rect = MAP_RECTANGLE(10, -5, 20, 5);
+        double start;
+        double width;
+
+        /* Point inside rectangle */
+        zassert_equal(real_equal(get_point_rectangle_distance(MAP_REAL(15), 0, &rect), 0,
+                                 EPSILON), true);
+
+        /* Point beside and diagonal to rectangle */
+        zassert_equal(real_equal(get_point_rectangle_distance(0, 0, &rect), 10, EPSILON), true);
+        zassert_equal(real_equal(get_point_rectangle_distance(MAP_REAL(23), MAP_REAL(9), &rect),
+                                 5, EPSILON), true);
+
+        /* Span straddling 0 degrees wraps around */
+        zassert_equal(get_rectangle_angular_span(0, 0, &rect, 0, &start, &width), 0);
+        zassert_equal(float_equal(start, 360 - atan2(5, 10) * 180 / M_PI), true);
+        zassert_equal(float_equal(width, 2 * atan2(5, 10) * 180 / M_PI), true);
+
+        /* Margin widens the span */
+        zassert_equal(get_rectangle_angular_span(0, 0, &rect, MAP_REAL(5), &start, &width), 0);
+        zassert_equal(float_equal(width, 2 * atan2(10, 5) * 180 / M_PI), true);
+
+        /* Point inside grown rectangle sees it in every direction */
+        zassert_equal(get_rectangle_angular_span(MAP_REAL(8), 0, &rect, MAP_REAL(5), &start,
+                                                 &width), -EDOM);
+}
+
+/* Double precision reference for a capsule, sampling points along the segment */
+static bool ref_capsule_collides(double x, double y, double angle_d, double len, double radius,
+                                 const double box[4])
+{
+        for (double s = 0; s <= len; s += 0.05) {
+                double px = x + s * cos(angle_d * M_PI / 180);
+                double py = y + s * sin(angle_d * M_PI / 180);
+                double dx = fmax(fmax(box[0] - px, 0), px - box[2]);
+                double dy = fmax(fmax(box[1] - py, 0), py - box[3]);
+
+                if (sqrt(dx * dx + dy * dy) <= radius) {
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+ZTEST(map_utils, test_capsule_blocked_span)
+{
+        const double box[4] = {20, 10, 30, 40};
+        struct rectangle rect = MAP_RECTANGLE(box[0], box[1], box[2], box[3]);
+        /* Pivots far away, beside, diagonal, within reach of a corner only, and inside */
+        const double pivots[][2] = {{-80, 25}, {0, 25}, {0, 0}, {45, -20}, {5, 60}, {25, 5}};
+        const double len = 40;
+        const double radius = 6;
+        double start;
+        double width;
+        int ret;
+
+        ret = get_capsule_blocked_span(MAP_REAL(-80), MAP_REAL(25), MAP_REAL(len),
+                                       MAP_REAL(radius), &rect, &start, &width);
+        zassert_equal(ret, -ENOENT);
+
+        ret = get_capsule_blocked_span(MAP_REAL(25), MAP_REAL(5), MAP_REAL(len),
+                                       MAP_REAL(radius), &rect, &start, &width);
+        zassert_equal(ret, -EDOM);
+
+        for (size_t i = 0; i < ARRAY_SIZE(pivots); i++) {
+                ret = get_capsule_blocked_span(MAP_REAL(pivots[i][0]), MAP_REAL(pivots[i][1]),
+                                               MAP_REAL(len), MAP_REAL(radius), &rect, &start,
+                                               &width);
+
+                for (double angle = 0; angle < 360; angle += 0.5) {
+                        double rel = fmod(angle - start + 720, 360);
+                        bool blocked = (ret == -EDOM) || (ret == 0 && rel <= width);
+
+                        /* Directions right on the edge of the span may round either way */
+                        if (ret == 0 && (fabs(rel - width) < 0.5 || rel > 359.5 || rel < 0.5)) {
+                                continue;
+                        }
+
+                        zassert_equal(blocked,
+                                      ref_capsule_collides(pivots[i][0], pivots[i][1], angle,
+                                                           len, radius, box),
+                                      "pivot %d angle %f", (int)i, angle);
+                }
+        }
+}
+
+ZTEST(map_utils, test_numeric_backend_cspace)
+{
+        /* Obstacles from the pathfinding examples, as min_x, min_y, max_x, max_y */
+        const double boxes[][4] = {{60, 90, 74, 104}, {200, 200, 225, 260}, {230, 170, 260, 195}};
+        int mismatches = 0;
+        int cells = 0;
+
+        for (size_t i = 0; i < ARRAY_SIZE(boxes); i++) {
+                struct rectangle rect = MAP_RECTANGLE(boxes[i][0], boxes[i][1], boxes[i][2],
+                                                      boxes[i][3]);
+
+                for (int theta0 = 0; theta0 < 180; theta0++) {
+                        for (int theta1 = 0; theta1 < 180; theta1++) {
+                                map_real_t x0;
+                                map_real_t y0;
+                                map_real_t x1;
+                                map_real_t y1;
+                                double ref_x0;
+                                double ref_y0;
+                                double ref_x1;
+                                double ref_y1;
+
+                                /* Elbow, then the wrist of the same configuration */
+                                get_segment_endpoint_lut(MAP_REAL(ARM_LEN),
+                                                         MAP_UTILS_DEG_TO_STEPS(theta0), &x0, &y0);
+                                get_arm_endpoint_lut(MAP_UTILS_DEG_TO_STEPS(theta0),
+                                                     MAP_UTILS_DEG_TO_STEPS(theta1),
+                                                     MAP_REAL(ARM_LEN), MAP_REAL(ARM_ORIGIN_X),
+                                                     MAP_REAL(ARM_ORIGIN_Y), &x1, &y1);
+                                x0 += MAP_REAL(ARM_ORIGIN_X);
+                                y0 += MAP_REAL(ARM_ORIGIN_Y);
+
+                                get_segment_endpoint_trig(ARM_LEN, theta0, &ref_x0, &ref_y0);
+                                get_arm_endpoint(theta0, theta1, ARM_LEN, 180, ARM_ORIGIN_X,
+                                                 ARM_ORIGIN_Y, &ref_x1, &ref_y1);
+                                ref_x0 += ARM_ORIGIN_X;
+                                ref_y0 += ARM_ORIGIN_Y;
+
+                                struct segment arm0 = {MAP_REAL(ARM_ORIGIN_X),
+                                                       MAP_REAL(ARM_ORIGIN_Y), x0, y0};
+                                struct segment arm1 = {x0, y0, x1, y1};
+                                bool occupied = arm_collides(arm0, rect) ||
+                                                arm_collides(arm1, rect);
+                                bool ref_occupied =
+                                        ref_arm_collides(ARM_ORIGIN_X, ARM_ORIGIN_Y, ref_x0,
+                                                         ref_y0, boxes[i]) ||
+                                        ref_arm_collides(ref_x0, ref_y0, ref_x1, ref_y1,
+                                                         boxes[i]);
+
+                                mismatches += occupied != ref_occupied;
+                                cells++;
+                        }
+                }
+        }
+
+        /* Only configurations grazing an obstacle edge may differ */
+        zassert_true(mismatches * 200 <= cells, "%d of %d configurations differ", mismatches,
+                     cells);
+}
+
 ZTEST(map_utils, test_segment_intersect)
 {
         struct segment s1;
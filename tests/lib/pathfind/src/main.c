@@ -0,0 +1,285 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <lib/pathfind/kinematics.h>
+#include <lib/pathfind/pathfinding.h>
+#include <lib/pathfind/spaces.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Overlapping obstacles, so cells blocked by several of them are reference counted */
+static const struct obstacle obstacle_a = MAP_OBSTACLE_RECTANGLE(100, 120, 160, 160);
+static const struct obstacle obstacle_b = MAP_OBSTACLE_RECTANGLE(140, 140, 200, 180);
+static const struct obstacle obstacle_c = MAP_OBSTACLE_RECTANGLE(190, 100, 230, 150);
+static const struct obstacle obstacle_d = MAP_OBSTACLE_RECTANGLE(250, 60, 280, 90);
+
+/* Rectangle to the right of the arm, as in the pathfind sample */
+static const struct obstacle obstacle_right = MAP_OBSTACLE_RECTANGLE(230, 170, 260, 195);
+
+static uint32_t cspace_copy[CSPACE_DIMENSION][CSPACE_ROW_WORDS];
+static uint8_t wspace_copy[WORKSPACE_DIMENSION][WORKSPACE_DIMENSION];
+
+/**
+ * @brief Check the incrementally updated spaces against a fresh generation
+ *
+ * Leaves the freshly generated spaces in place.
+ */
+static void assert_matches_generation(void)
+{
+        memcpy(cspace_copy, get_cspace(), sizeof(cspace_copy));
+        memcpy(wspace_copy, get_wspace(), sizeof(wspace_copy));
+
+        zassert_ok(generate_configuration_space());
+
+        zassert_equal(memcmp(cspace_copy, get_cspace(), sizeof(cspace_copy)), 0);
+        zassert_equal(memcmp(wspace_copy, get_wspace(), sizeof(wspace_copy)), 0);
+}
+
+ZTEST(pathfind, test_dynamic_obstacles)
+{
+        zassert_ok(add_obstacle(&obstacle_a));
+        zassert_ok(add_obstacle(&obstacle_b));
+        zassert_ok(generate_configuration_space());
+
+        /* Removing B renumbers C into its slot and redraws A over their shared cells */
+        zassert_ok(add_obstacle(&obstacle_c));
+        zassert_ok(remove_obstacle(&obstacle_b));
+        assert_matches_generation();
+
+        zassert_ok(move_obstacle(&obstacle_c, &obstacle_d));
+        assert_matches_generation();
+
+        zassert_equal(remove_obstacle(&obstacle_b), -ENOENT);
+        zassert_equal(move_obstacle(&obstacle_c, &obstacle_b), -ENOENT);
+
+        zassert_ok(remove_obstacle(&obstacle_a));
+        zassert_ok(remove_obstacle(&obstacle_d));
+}
+
+/**
+ * @brief Planner query, from a configuration to a workspace target
+ */
+struct query {
+        int theta0;
+        int theta1;
+        int x;
+        int y;
+};
+
+static bool goal_set[CSPACE_DIMENSION][CSPACE_DIMENSION];
+static int16_t bfs_steps[CSPACE_DIMENSION][CSPACE_DIMENSION];
+static uint16_t bfs_queue[CSPACE_DIMENSION * CSPACE_DIMENSION];
+static struct pathfinding_steps plan[MAX_NUM_STEPS];
+
+static int add_goal(struct arm_angles angles, void *user_data)
+{
+        if (!cspace_is_occupied(angles.theta0, angles.theta1)) {
+                goal_set[CSPACE_CELL(angles.theta0)][CSPACE_CELL(angles.theta1)] = true;
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Breadth first search for the fewest steps from a configuration to the goal set
+ *
+ * Steps to any of the eight neighbouring free cells, leaving out the first row and
+ * column like the planner does.
+ *
+ * @retval Number of steps, -1 if the goal set can't be reached
+ */
+static int bfs_reference(int theta0, int theta1)
+{
+        int head = 0;
+        int tail = 0;
+
+        memset(bfs_steps, -1, sizeof(bfs_steps));
+        bfs_steps[CSPACE_CELL(theta0)][CSPACE_CELL(theta1)] = 0;
+        bfs_queue[tail++] = (CSPACE_CELL(theta0) * CSPACE_DIMENSION) + CSPACE_CELL(theta1);
+
+        while (head < tail) {
+                int x = bfs_queue[head] / CSPACE_DIMENSION;
+                int y = bfs_queue[head++] % CSPACE_DIMENSION;
+
+                if (goal_set[x][y]) {
+                        return bfs_steps[x][y];
+                }
+
+                for (int dx = -1; dx <= 1; dx++) {
+                        for (int dy = -1; dy <= 1; dy++) {
+                                int nx = x + dx;
+                                int ny = y + dy;
+
+                                if (nx < 1 || ny < 1 || nx >= CSPACE_DIMENSION ||
+                                    ny >= CSPACE_DIMENSION || bfs_steps[nx][ny] >= 0 ||
+                                    cspace_is_occupied(CSPACE_ANGLE(nx), CSPACE_ANGLE(ny))) {
+                                        continue;
+                                }
+
+                                bfs_steps[nx][ny] = bfs_steps[x][y] + 1;
+                                bfs_queue[tail++] = (nx * CSPACE_DIMENSION) + ny;
+                        }
+                }
+        }
+
+        return -1;
+}
+
+/**
+ * @brief Plan each query and check the plan against the cspace
+ *
+ * Every step has to move to a neighbouring free cell and the plan has to end in the
+ * goal set. A* and JPS plans also have to be as short as the BFS reference.
+ */
+static void assert_plans(const struct query *queries, size_t num_queries)
+{
+        for (size_t i = 0; i < num_queries; i++) {
+                const struct query *query = &queries[i];
+                int num_steps;
+
+                memset(goal_set, 0, sizeof(goal_set));
+                zassert_true(get_arm_goal_configurations(query->x, query->y,
+                                                         CONFIG_PATHFIND_ALLOWABLE_TOLERANCE_MM,
+                                                         add_goal, NULL) > 0);
+
+                zassert_ok(pathfinding_calculate_path(query->theta0, query->theta1, query->x,
+                                                      query->y, plan, &num_steps),
+                           "query %zu", i);
+                zassert_true(plan[0].theta0 == query->theta0 && plan[0].theta1 == query->theta1,
+                             "query %zu doesn't start at the start", i);
+
+                for (int j = 0; j < num_steps; j++) {
+                        zassert_false(cspace_is_occupied(plan[j].theta0, plan[j].theta1),
+                                      "query %zu step %d enters an obstacle", i, j);
+
+                        if (j > 0) {
+                                int d0 = abs(CSPACE_CELL(plan[j].theta0) -
+                                             CSPACE_CELL(plan[j - 1].theta0));
+                                int d1 = abs(CSPACE_CELL(plan[j].theta1) -
+                                             CSPACE_CELL(plan[j - 1].theta1));
+
+                                zassert_equal(MAX(d0, d1), 1,
+                                              "query %zu step %d isn't to a neighbour", i, j);
+                        }
+                }
+
+                zassert_true(goal_set[CSPACE_CELL(plan[num_steps - 1].theta0)]
+                                     [CSPACE_CELL(plan[num_steps - 1].theta1)],
+                             "query %zu doesn't end in the goal set", i);
+
+                if (IS_ENABLED(CONFIG_PATHFIND_SEARCH_ASTAR) ||
+                    IS_ENABLED(CONFIG_PATHFIND_SEARCH_JPS)) {
+                        zassert_equal(num_steps - 1, bfs_reference(query->theta0, query->theta1),
+                                      "query %zu isn't the shortest", i);
+                }
+
+                cleanup_cspace();
+        }
+}
+
+ZTEST(pathfind, test_plan_open_space)
+{
+        static const struct query queries[] = {
+                {150, 120, 345, 70},
+                {30, 60, 42, 70},
+                {100, 170, 270, 138},
+                {90, 20, 98, 109},
+        };
+
+        zassert_ok(generate_configuration_space());
+
+        assert_plans(queries, ARRAY_SIZE(queries));
+}
+
+ZTEST(pathfind, test_plan_word_boundaries)
+{
+        /*
+         * Obstacles whose cspace edges cross theta0 cells 31 and 32, 63 and 64, 95 and 96,
+         * where jump_row() carries the rows either side over from the next word. The
+         * queries come out longer than the BFS reference when most of those carries are
+         * dropped.
+         */
+        static const struct obstacle obstacles_a[] = {
+                MAP_OBSTACLE_RECTANGLE(292, 138, 326, 167),
+                MAP_OBSTACLE_RECTANGLE(88, 152, 115, 162),
+                MAP_OBSTACLE_RECTANGLE(327, 23, 333, 42),
+        };
+        static const struct query queries_a[] = {
+                {20, 108, 66, 108},
+                {7, 156, 45, 89},
+                {56, 165, 47, 86},
+        };
+        static const struct obstacle obstacles_b[] = {
+                MAP_OBSTACLE_RECTANGLE(266, 151, 290, 185),
+                MAP_OBSTACLE_RECTANGLE(307, 119, 317, 132),
+                MAP_OBSTACLE_RECTANGLE(110, 174, 132, 193),
+        };
+        static const struct query queries_b[] = {
+                {106, 147, 226, 175},
+                {129, 171, 155, 175},
+                {113, 154, 158, 176},
+        };
+        static const struct obstacle obstacles_c[] = {
+                MAP_OBSTACLE_RECTANGLE(275, 27, 288, 36),
+                MAP_OBSTACLE_RECTANGLE(310, 88, 338, 109),
+                MAP_OBSTACLE_RECTANGLE(260, 146, 293, 177),
+        };
+        static const struct query queries_c[] = {
+                {36, 34, 232, 145},
+                {71, 9, 159, 146},
+        };
+        static const struct {
+                const struct obstacle *obstacles;
+                const struct query *queries;
+                size_t num_queries;
+        } scenes[] = {
+                {obstacles_a, queries_a, ARRAY_SIZE(queries_a)},
+                {obstacles_b, queries_b, ARRAY_SIZE(queries_b)},
+                {obstacles_c, queries_c, ARRAY_SIZE(queries_c)},
+        };
+
+        for (size_t i = 0; i < ARRAY_SIZE(scenes); i++) {
+                for (int j = 0; j < 3; j++) {
+                        zassert_ok(add_obstacle(&scenes[i].obstacles[j]));
+                }
+                zassert_ok(generate_configuration_space());
+
+                for (int x = 32; x <= 96; x += 32) {
+                        bool straddled = false;
+
+                        for (int y = 1; y < CSPACE_DIMENSION && !straddled; y++) {
+                                straddled = cspace_is_occupied(CSPACE_ANGLE(x - 1),
+                                                               CSPACE_ANGLE(y)) !=
+                                            cspace_is_occupied(CSPACE_ANGLE(x), CSPACE_ANGLE(y));
+                        }
+
+                        zassert_true(straddled, "scene %zu has no edge at theta0 cell %d", i, x);
+                }
+
+                assert_plans(scenes[i].queries, scenes[i].num_queries);
+
+                for (int j = 0; j < 3; j++) {
+                        zassert_ok(remove_obstacle(&scenes[i].obstacles[j]));
+                }
+        }
+}
+
+ZTEST(pathfind, test_long_query)
+{
+        static const struct query queries[] = {
+                {173, 88, 268, 164},
+        };
+
+        zassert_ok(add_obstacle(&obstacle_right));
+        zassert_ok(generate_configuration_space());
+
+        /* A* reaches about 12000 cells on the way, JPS fits the default node pool */
+        assert_plans(queries, ARRAY_SIZE(queries));
+
+        zassert_ok(remove_obstacle(&obstacle_right));
+}
+
+ZTEST_SUITE(pathfind, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,27 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STATIC_OBSTACLES_H_
+#define STATIC_OBSTACLES_H_
+
+#include <lib/map_utils.h>
+
+/**
+ * @brief Array of known workspace obstacles
+ *
+ * Also compiled on the host when the cspace is generated at build time.
+ */
+static const struct obstacle static_obstacles[] = {
+
+	// /* Rectangle off to the left of arm */
+	// MAP_OBSTACLE_RECTANGLE(60, 90, 74, 104),
+
+	// /* Rectangle directly above arm and middle */
+	// MAP_OBSTACLE_RECTANGLE(200, 200, 225, 260),
+
+	/* Rectangle middle to the right */
+	MAP_OBSTACLE_RECTANGLE(230, 170, 260, 195),
+};
+
+#endif /* STATIC_OBSTACLES_H_ */
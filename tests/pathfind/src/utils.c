@@ -5,14 +5,14 @@
 #include <stdio.h>
 #include <utils.h>
 
-static void print_cspace(uint8_t (*cspace)[CSPACE_DIMENSION])
+static void print_cspace(void)
 {
 	/* Print cspace marker */
 	printf("%s\n", CSPACE_MARKER);
 
 	for (int i = 0; i < CSPACE_DIMENSION; i++) {
 		for (int j = 0; j < CSPACE_DIMENSION; j++) {
-			printf("%d", cspace[i][j]);
+			printf("%d", get_cspace_marker(CSPACE_ANGLE(j), CSPACE_ANGLE(i)));
 		}
 		printf("\n");
 	}
@@ -21,14 +21,14 @@ static void print_cspace(uint8_t (*cspace)[CSPACE_DIMENSION])
 	printf("%s\n", CSPACE_MARKER);
 }
 
-static void print_wspace(uint8_t (*wspace)[WORKSPACE_DIMENSION])
+static void print_wspace(void)
 {
 	/* Print wspace marker */
 	printf("%s\n", WSPACE_MARKER);
 
 	for (int i = 0; i < WORKSPACE_DIMENSION; i++) {
 		for (int j = 0; j < WORKSPACE_DIMENSION; j++) {
-			printf("%d", wspace[i][j]);
+			printf("%d", get_wspace_marker(j, i));
 		}
 		printf("\n");
 	}
@@ -37,10 +37,10 @@ static void print_wspace(uint8_t (*wspace)[WORKSPACE_DIMENSION])
 	printf("%s\n", WSPACE_MARKER);
 }
 
-void print_spaces(uint8_t (*cspace)[CSPACE_DIMENSION], uint8_t (*wspace)[WORKSPACE_DIMENSION])
+void print_spaces(void)
 {
-	print_cspace(cspace);
-	print_wspace(wspace);
+	print_cspace();
+	print_wspace();
 
 	/* Print done message */
 	printf("%s\n", SPACE_MARKER);